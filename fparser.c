@@ -20,13 +20,60 @@ void parseCommand(struct FileSystem *fs, const char *command)
     {
         char *path = strtok(NULL, " ");
         char *fileName = strtok(NULL, " ");
-        if (path != NULL && fileName != NULL)
+
+        // find -g <path> <glob> and find -x <path> <regex> match names against a pattern
+        if (path != NULL && (strcmp(path, "-g") == 0 || strcmp(path, "-x") == 0))
+        {
+            char *pattern = strtok(NULL, " ");
+            if (fileName != NULL && pattern != NULL)
+            {
+                searchFilesByPattern(fs, fileName, pattern, path[1] == 'g' ? PATTERN_GLOB : PATTERN_REGEX);
+                return;
+            }
+        }
+        else if (path != NULL && fileName != NULL)
         {
             searchFileInPath(fs, path, fileName);
             return;
         }
     }
 
+    if (strcmp(cmd, "du") == 0)
+    {
+        char *path = strtok(NULL, " ");
+        if (path != NULL)
+        {
+            diskUsageAtPath(fs, path);
+            return;
+        }
+    }
+
+    if (strcmp(cmd, "grep") == 0)
+    {
+        char *path = strtok(NULL, " ");
+        char *pattern = strtok(NULL, "");
+        if (path != NULL && pattern != NULL)
+        {
+            grepInPath(fs, path, pattern);
+            return;
+        }
+    }
+
+    if (strcmp(cmd, "stats") == 0)
+    {
+        displayFileSystemStats(fs);
+        return;
+    }
+
+    // sync [path [name]] flushes writes to files loaded with a writable mapping
+    if (strcmp(cmd, "sync") == 0)
+    {
+        char *path = strtok(NULL, " ");
+        char *fileName = path != NULL ? strtok(NULL, " ") : NULL;
+        syncFiles(fs, path, fileName);
+        return;
+    }
+
     if (strcmp(cmd, "dispd") == 0)
     {
         char *path = strtok(NULL, " ");
@@ -48,30 +95,100 @@ void parseCommand(struct FileSystem *fs, const char *command)
         }
     }
 
+    // rf <path> <name> [offset [length]]
     if (strcmp(cmd, "rf") == 0)
     {
         char *filePath = strtok(NULL, " ");
         char *fileName = strtok(NULL, " ");
+        char *offsetStr = strtok(NULL, " ");
+        char *lengthStr = strtok(NULL, " ");
 
-        if (filePath != NULL && fileName != NULL)
+        if (filePath != NULL && fileName != NULL && offsetStr == NULL)
         {
             readFile(fs, filePath, fileName);
             return;
         }
+
+        if (filePath != NULL && fileName != NULL)
+        {
+            char *offsetEnd;
+            char *lengthEnd = "";
+            unsigned long long offset = strtoull(offsetStr, &offsetEnd, 10);
+            unsigned long long length = lengthStr != NULL ? strtoull(lengthStr, &lengthEnd, 10) : UINT64_MAX;
+            if (*offsetEnd != '\0' || !isdigit((unsigned char)offsetStr[0]) ||
+                *lengthEnd != '\0' || (lengthStr != NULL && !isdigit((unsigned char)lengthStr[0])))
+            {
+                printf("Invalid offset or length.\n");
+                return;
+            }
+            readFileRange(fs, filePath, fileName, offset, length);
+            return;
+        }
     }
 
     if (strcmp(cmd, "load") == 0)
     {
+        // Leading flags: -s, -R or -w for a sequential, random or willneed access hint, -p to
+        // populate the mapping up front, -H for huge pages, -m to keep serving from the mapping,
+        // -W to serve from a writable mapping whose writes reach the host file on sync, -l to
+        // only record the host file and map it when first read, and -r to load a whole host
+        // directory: load -r <hostDir> <subsystemPath>
+        struct LoadOptions options = {{ACCESS_NORMAL, 0, 0, 0}, 0, 0};
+        int recursive = 0;
         char *fileName = strtok(NULL, " ");
-        char *windowsPath = strtok(NULL, " ");
+        while (fileName != NULL && fileName[0] == '-' && fileName[1] != '\0' && fileName[2] == '\0')
+        {
+            switch (fileName[1])
+            {
+            case 's':
+                options.map.hint = ACCESS_SEQUENTIAL;
+                break;
+            case 'R':
+                options.map.hint = ACCESS_RANDOM;
+                break;
+            case 'r':
+                recursive = 1;
+                break;
+            case 'w':
+                options.map.hint = ACCESS_WILLNEED;
+                break;
+            case 'p':
+                options.map.populate = 1;
+                break;
+            case 'H':
+                options.map.huge_pages = 1;
+                break;
+            case 'm':
+                options.keep_mapping = 1;
+                break;
+            case 'W':
+                options.keep_mapping = 1;
+                options.map.writable = 1;
+                break;
+            case 'l':
+                options.keep_mapping = 1;
+                options.lazy = 1;
+                break;
+            default:
+                printf("Unknown load option '%s'.\n", fileName);
+                return;
+            }
+            fileName = strtok(NULL, " ");
+        }
+        char *hostPath = strtok(NULL, " ");
         char *subsystemPath = strtok(NULL, " ");
 
-        if (fileName != NULL && windowsPath != NULL && subsystemPath != NULL)
+        if (recursive && fileName != NULL && hostPath != NULL)
+        {
+            loadHostTree(fs, fileName, hostPath, &options);
+            return;
+        }
+        if (!recursive && fileName != NULL && hostPath != NULL && subsystemPath != NULL)
         {
-            int result = loadFileContent(fileName, windowsPath, subsystemPath, fs);
+            int result = loadFileContent(fileName, hostPath, subsystemPath, fs, &options);
             if (result == 0)
             {
-                printf("File '%s' loaded into subsystem file '%s/%s'.\n", windowsPath, subsystemPath, fileName);
+                printf("File '%s' loaded into subsystem file '%s/%s'.\n", hostPath, subsystemPath, fileName);
                 return;
             }
             else
@@ -86,18 +203,32 @@ void parseCommand(struct FileSystem *fs, const char *command)
     {
         char *fileName = strtok(NULL, " ");
         char *subsystemPath = strtok(NULL, " ");
-        char *windowsPath = strtok(NULL, " ");
+        char *hostPath = strtok(NULL, " ");
+
+        // out -r <subsystemPath> <hostDir> writes a whole directory tree
+        if (fileName != NULL && strcmp(fileName, "-r") == 0)
+        {
+            if (subsystemPath != NULL && hostPath != NULL)
+            {
+                outHostTree(fs, subsystemPath, hostPath);
+            }
+            else
+            {
+                printf("Invalid parameters provided for 'output'.\n");
+            }
+            return;
+        }
 
-        if (fileName != NULL && subsystemPath != NULL && windowsPath != NULL)
+        if (fileName != NULL && subsystemPath != NULL && hostPath != NULL)
         {
-            int result = outFileContent(fileName, subsystemPath, windowsPath, fs);
+            int result = outFileContent(fileName, subsystemPath, hostPath, fs);
             if (result == 0)
             {
-                printf("File content successfully written to Windows file '%s' from subsystem '%s/%s'.\n", windowsPath, subsystemPath, fileName);
+                printf("File content successfully written to host file '%s' from subsystem '%s/%s'.\n", hostPath, subsystemPath, fileName);
             }
             else
             {
-                printf("Failed to write file content to Windows file '%s' from subsystem '%s/%s'.\n", windowsPath, subsystemPath, fileName);
+                printf("Failed to write file content to host file '%s' from subsystem '%s/%s'.\n", hostPath, subsystemPath, fileName);
             }
         }
         else
@@ -170,6 +301,74 @@ void parseCommand(struct FileSystem *fs, const char *command)
                 return;
             }
         }
+
+        // cp <path> <name> <destination> or cp -r <path> <destination>
+        if (strcmp(cmd, "cp") == 0)
+        {
+            char *first = strtok(NULL, " ");
+            char *second = strtok(NULL, " ");
+            char *third = strtok(NULL, " ");
+            int recursive = first != NULL && strcmp(first, "-r") == 0;
+            char *sourcePath = recursive ? second : first;
+            char *destinationPath = third;
+
+            if (sourcePath != NULL && destinationPath != NULL)
+            {
+                struct Directory *sourceDir = goTo(fs, sourcePath);
+                struct Directory *destinationDir = goTo(fs, destinationPath);
+                if (sourceDir != NULL && destinationDir != NULL &&
+                    (fs->current_user.access_level < sourceDir->access || fs->current_user.access_level < destinationDir->access))
+                {
+                    printf("Access denied. Insufficient privileges to copy.\n");
+                    return;
+                }
+
+                if (recursive)
+                {
+                    copyDirectoryToPath(fs, sourcePath, destinationPath);
+                }
+                else
+                {
+                    copyFileToPath(fs, sourcePath, second, destinationPath);
+                }
+                return;
+            }
+        }
+
+        if (strcmp(cmd, "af") == 0)
+        {
+            char *filePath = strtok(NULL, " ");
+            char *fileName = strtok(NULL, " ");
+            char *content = strtok(NULL, "\n");
+
+            if (filePath != NULL && fileName != NULL && content != NULL)
+            {
+                appendToFileAtPath(fs, filePath, fileName, content);
+                return;
+            }
+        }
+
+        // wat <path> <name> <offset> <content>: overwrite in place from the offset
+        if (strcmp(cmd, "wat") == 0)
+        {
+            char *filePath = strtok(NULL, " ");
+            char *fileName = strtok(NULL, " ");
+            char *offsetStr = strtok(NULL, " ");
+            char *content = strtok(NULL, "\n");
+
+            if (filePath != NULL && fileName != NULL && offsetStr != NULL && content != NULL)
+            {
+                char *end;
+                unsigned long long offset = strtoull(offsetStr, &end, 10);
+                if (*end != '\0' || !isdigit((unsigned char)offsetStr[0]))
+                {
+                    printf("Invalid offset: %s\n", offsetStr);
+                    return;
+                }
+                writeToFileAtPath(fs, filePath, fileName, offset, content);
+                return;
+            }
+        }
     }
 
     if (currentUserLevel >= HIGH)
@@ -205,6 +404,65 @@ void parseCommand(struct FileSystem *fs, const char *command)
             }
         }
 
+        if (strcmp(cmd, "tindex") == 0)
+        {
+            char *path = strtok(NULL, " ");
+            char *state = strtok(NULL, " ");
+            if (path != NULL && state != NULL && (strcmp(state, "on") == 0 || strcmp(state, "off") == 0))
+            {
+                setContentIndexing(fs, path, strcmp(state, "on") == 0);
+                return;
+            }
+        }
+
+        if (strcmp(cmd, "compress") == 0)
+        {
+            char *path = strtok(NULL, " ");
+            char *state = strtok(NULL, " ");
+            if (path != NULL && state != NULL && (strcmp(state, "on") == 0 || strcmp(state, "off") == 0))
+            {
+                setContentCompression(fs, path, strcmp(state, "on") == 0);
+                return;
+            }
+        }
+
+        // hostio <uring|threads> [queueDepth] [inflightMB]
+        if (strcmp(cmd, "hostio") == 0)
+        {
+            char *backend = strtok(NULL, " ");
+            char *depthStr = strtok(NULL, " ");
+            char *inflightStr = strtok(NULL, " ");
+            char *depthEnd = "";
+            char *inflightEnd = "";
+            unsigned long depth = depthStr != NULL ? strtoul(depthStr, &depthEnd, 10) : 0;
+            unsigned long inflight = inflightStr != NULL ? strtoul(inflightStr, &inflightEnd, 10) : 0;
+            if (backend != NULL && *depthEnd == '\0' && *inflightEnd == '\0' && inflight <= 1048576 &&
+                (depthStr == NULL || isdigit((unsigned char)depthStr[0])) && (inflightStr == NULL || isdigit((unsigned char)inflightStr[0])))
+            {
+                setHostIo(fs, backend, depth > 1000000 ? 1000000 : (unsigned)depth, (unsigned)inflight);
+                return;
+            }
+        }
+
+        if (strcmp(cmd, "rn") == 0)
+        {
+            char *path = strtok(NULL, " ");
+            char *newName = strtok(NULL, " ");
+            if (path != NULL && newName != NULL)
+            {
+                struct Directory *dir = goTo(fs, path);
+
+                if (dir != NULL && fs->current_user.access_level < dir->access)
+                {
+                    printf("Insufficient permissions to rename the directory.\n");
+                    return;
+                }
+
+                renameDirectoryAtPath(fs, path, newName);
+                return;
+            }
+        }
+
         if (strcmp(cmd, "mf") == 0)
         {
             char *sourcePath = strtok(NULL, " ");
@@ -248,7 +506,8 @@ void parseCommand(struct FileSystem *fs, const char *command)
             char *flag = strtok(NULL, " ");
             if (flag != NULL)
             {
-                if (strcmp(flag, "-d") == 0)
+                // -d changes the immediate subdirectories, -r everything below the path
+                if (strcmp(flag, "-d") == 0 || strcmp(flag, "-r") == 0)
                 {
                     char *path = strtok(NULL, " ");
                     char *fileName = NULL;
@@ -270,7 +529,14 @@ void parseCommand(struct FileSystem *fs, const char *command)
                         newAccessLevel = HIGH;
                     }
 
-                    changeDirectoryAccessLevel(fs, path, newAccessLevel);
+                    if (strcmp(flag, "-r") == 0)
+                    {
+                        changeAccessLevelRecursive(fs, path, newAccessLevel);
+                    }
+                    else
+                    {
+                        changeDirectoryAccessLevel(fs, path, newAccessLevel);
+                    }
                     return;
                 }
             }
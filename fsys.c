@@ -1,585 +1,7107 @@
 #include "fsys.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FSYS_HAVE_SSE2 1
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#ifdef IORING_FEAT_CUR_PERSONALITY // Headers from Linux 5.6 on, which has every operation the batches use
+#define FSYS_HAVE_URING 1
+#endif
+#endif
+#endif
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+// Platform layer. Everything else reaches the OS through these functions.
+
+struct PlatformThreadStart
+{
+    void (*entry)(void *);
+    void *argument;
+};
+
+#ifdef _WIN32
+static DWORD WINAPI platformThreadMain(LPVOID param)
+#else
+static void *platformThreadMain(void *param)
+#endif
+{
+    struct PlatformThreadStart start = *(struct PlatformThreadStart *)param;
+    free(param);
+    start.entry(start.argument);
+    return 0;
+}
+
+int startPlatformThread(PlatformThread *thread, void (*entry)(void *), void *argument)
+{
+    struct PlatformThreadStart *start = malloc(sizeof(struct PlatformThreadStart));
+    if (start == NULL)
+    {
+        return -1;
+    }
+    start->entry = entry;
+    start->argument = argument;
+
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, platformThreadMain, start, 0, NULL);
+    if (*thread == NULL)
+#else
+    if (pthread_create(thread, NULL, platformThreadMain, start) != 0)
+#endif
+    {
+        free(start);
+        return -1;
+    }
+    return 0;
+}
+
+void joinPlatformThread(PlatformThread thread)
+{
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+void yieldPlatformThread(void)
+{
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+int processorCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
+void initPlatformLock(PlatformLock *lock)
+{
+#ifdef _WIN32
+    InitializeCriticalSection(lock);
+#else
+    pthread_mutex_init(lock, NULL);
+#endif
+}
+
+void deletePlatformLock(PlatformLock *lock)
+{
+#ifdef _WIN32
+    DeleteCriticalSection(lock);
+#else
+    pthread_mutex_destroy(lock);
+#endif
+}
+
+void acquirePlatformLock(PlatformLock *lock)
+{
+#ifdef _WIN32
+    EnterCriticalSection(lock);
+#else
+    pthread_mutex_lock(lock);
+#endif
+}
+
+void releasePlatformLock(PlatformLock *lock)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(lock);
+#else
+    pthread_mutex_unlock(lock);
+#endif
+}
+
+long atomicIncrement(volatile long *value)
+{
+#ifdef _WIN32
+    return InterlockedIncrement(value);
+#else
+    return __atomic_add_fetch(value, 1, __ATOMIC_SEQ_CST);
+#endif
+}
+
+long atomicDecrement(volatile long *value)
+{
+#ifdef _WIN32
+    return InterlockedDecrement(value);
+#else
+    return __atomic_sub_fetch(value, 1, __ATOMIC_SEQ_CST);
+#endif
+}
+
+long atomicRead(volatile long *value)
+{
+#ifdef _WIN32
+    return InterlockedCompareExchange(value, 0, 0);
+#else
+    return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Sets *value to 'desired' if it holds 'expected'; returns what it held
+long atomicCompareExchange(volatile long *value, long expected, long desired)
+{
+#ifdef _WIN32
+    return InterlockedCompareExchange(value, desired, expected);
+#else
+    __atomic_compare_exchange_n(value, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return expected;
+#endif
+}
+
+void atomicAdd64(volatile int64_t *value, int64_t amount)
+{
+#ifdef _WIN32
+    InterlockedExchangeAdd64((volatile LONGLONG *)value, amount);
+#else
+    __atomic_add_fetch(value, amount, __ATOMIC_RELAXED);
+#endif
+}
+
+// Reads one key without echo. Enter reads as '\r' and erase as '\b' everywhere; the end of
+// input reads as Enter, so prompt loops always finish.
+int readConsoleKey(void)
+{
+#ifdef _WIN32
+    return _getch();
+#else
+    struct termios saved;
+    int raw = tcgetattr(STDIN_FILENO, &saved) == 0;
+    if (raw)
+    {
+        struct termios settings = saved;
+        settings.c_lflag &= ~(ICANON | ECHO);
+        tcsetattr(STDIN_FILENO, TCSANOW, &settings);
+    }
+
+    fflush(stdout);
+    int ch = getchar();
+
+    if (raw)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    }
+    if (ch == '\n' || ch == EOF)
+    {
+        return '\r';
+    }
+    return ch == 127 ? '\b' : ch;
+#endif
+}
+
+double getMilliseconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1e6;
+#endif
+}
+
+#ifndef _WIN32
+static int64_t hostModifiedTime(const struct stat *info)
+{
+#ifdef __linux__
+    return (int64_t)info->st_mtim.tv_sec * 1000000000 + info->st_mtim.tv_nsec;
+#else
+    return (int64_t)info->st_mtime * 1000000000;
+#endif
+}
+#endif
+
+// Maps a whole host file, with 64-bit sizes: read-only and private, or shared and writable so
+// writes through the view land in the host file. The hint goes to madvise (or the matching
+// Win32 file flags); populating faults every page in before returning. Huge pages are a
+// request: Linux backs file mappings with them only where the file system allows it, and
+// Win32 has no large pages for file views, so they are ignored there.
+int mapHostFile(const char *path, const struct MapOptions *options, struct HostMapping *mapping)
+{
+    mapping->data = NULL;
+    mapping->size = 0;
+    mapping->modified = 0;
+    mapping->writable = options->writable;
+
+#ifdef _WIN32
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (options->hint == ACCESS_SEQUENTIAL)
+    {
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    }
+    else if (options->hint == ACCESS_RANDOM)
+    {
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+    }
+
+    DWORD access = options->writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+    HANDLE hFile = CreateFile(path, access, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        printf("Failed to open host file '%s'.\n", path);
+        return -1;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) || (uint64_t)fileSize.QuadPart >= SIZE_MAX)
+    {
+        printf("Invalid file size for host file '%s'.\n", path);
+        CloseHandle(hFile);
+        return -1;
+    }
+
+    FILETIME written;
+    GetFileTime(hFile, NULL, NULL, &written);
+    mapping->modified = (int64_t)(((uint64_t)written.dwHighDateTime << 32) | written.dwLowDateTime);
+
+    // Empty files cannot be mapped
+    mapping->size = (uint64_t)fileSize.QuadPart;
+    if (mapping->size == 0)
+    {
+        CloseHandle(hFile);
+        return 0;
+    }
+
+    DWORD protection = options->writable ? PAGE_READWRITE : PAGE_READONLY;
+    HANDLE hMapFile = CreateFileMapping(hFile, NULL, protection, (DWORD)(mapping->size >> 32), (DWORD)mapping->size, NULL);
+    CloseHandle(hFile);
+    if (hMapFile == NULL)
+    {
+        printf("Failed to map host file '%s'.\n", path);
+        return -1;
+    }
+
+    // The view keeps the mapping alive once both handles are closed
+    const char *data = MapViewOfFile(hMapFile, options->writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, (SIZE_T)mapping->size);
+    CloseHandle(hMapFile);
+    if (data == NULL)
+    {
+        printf("Failed to map view of host file '%s'.\n", path);
+        return -1;
+    }
+
+#if _WIN32_WINNT >= 0x0602
+    if (options->hint == ACCESS_WILLNEED)
+    {
+        WIN32_MEMORY_RANGE_ENTRY range = {(PVOID)data, (SIZE_T)mapping->size};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#endif
+    if (options->populate)
+    {
+        volatile char sink = 0;
+        for (uint64_t offset = 0; offset < mapping->size; offset += 4096)
+        {
+            sink ^= data[offset];
+        }
+        (void)sink;
+    }
+#else
+    int fd = open(path, (options->writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (fd < 0)
+    {
+        printf("Failed to open host file '%s'.\n", path);
+        return -1;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || (uint64_t)info.st_size >= SIZE_MAX)
+    {
+        printf("Invalid file size for host file '%s'.\n", path);
+        close(fd);
+        return -1;
+    }
+
+    // Empty files cannot be mapped
+    mapping->modified = hostModifiedTime(&info);
+    mapping->size = (uint64_t)info.st_size;
+    if (mapping->size == 0)
+    {
+        close(fd);
+        return 0;
+    }
+
+    int flags = options->writable ? MAP_SHARED : MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (options->populate)
+    {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    int protection = options->writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    char *data = mmap(NULL, (size_t)mapping->size, protection, flags, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        printf("Failed to map host file '%s'.\n", path);
+        return -1;
+    }
+
+    static const int advice[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED};
+    if (options->hint != ACCESS_NORMAL)
+    {
+        madvise(data, (size_t)mapping->size, advice[options->hint]);
+    }
+#ifdef MADV_HUGEPAGE
+    if (options->huge_pages)
+    {
+        madvise(data, (size_t)mapping->size, MADV_HUGEPAGE);
+    }
+#endif
+#ifndef MAP_POPULATE
+    if (options->populate)
+    {
+        volatile char sink = 0;
+        for (uint64_t offset = 0; offset < mapping->size; offset += 4096)
+        {
+            sink ^= data[offset];
+        }
+        (void)sink;
+    }
+#endif
+#endif
+
+    mapping->data = data;
+    return 0;
+}
+
+void unmapHostFile(struct HostMapping *mapping)
+{
+    if (mapping->data != NULL)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping->data);
+#else
+        munmap((void *)mapping->data, (size_t)mapping->size);
+#endif
+    }
+    mapping->data = NULL;
+    mapping->size = 0;
+}
+
+// Sets the length of the host file behind a writable mapping and maps it again at that size;
+// bytes past the old end read as zeros. Nothing changes if it fails.
+int resizeHostMapping(const char *path, struct HostMapping *mapping, uint64_t size)
+{
+    if (!mapping->writable || size >= SIZE_MAX)
+    {
+        return -1;
+    }
+    if (size == mapping->size)
+    {
+        return 0;
+    }
+
+#ifdef _WIN32
+    // A view pins the file's length, so it goes before the file is resized
+    HANDLE hFile = CreateFile(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return -1;
+    }
+    struct HostMapping old = *mapping;
+    unmapHostFile(mapping);
+    LARGE_INTEGER length;
+    length.QuadPart = (LONGLONG)size;
+    if (!SetFilePointerEx(hFile, length, NULL, FILE_BEGIN) || !SetEndOfFile(hFile))
+    {
+        length.QuadPart = (LONGLONG)old.size;
+        size = old.size;
+        SetFilePointerEx(hFile, length, NULL, FILE_BEGIN);
+        SetEndOfFile(hFile);
+    }
+
+    const char *data = NULL;
+    if (size > 0)
+    {
+        HANDLE hMapFile = CreateFileMapping(hFile, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+        data = hMapFile != NULL ? MapViewOfFile(hMapFile, FILE_MAP_WRITE, 0, 0, (SIZE_T)size) : NULL;
+        if (hMapFile != NULL)
+        {
+            CloseHandle(hMapFile);
+        }
+    }
+    CloseHandle(hFile);
+    mapping->data = data;
+    mapping->size = data != NULL ? size : 0;
+    return size == old.size || (size > 0 && data == NULL) ? -1 : 0;
+#else
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, (off_t)size) != 0)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+
+    void *data = NULL;
+    if (size > 0 && mapping->data != NULL)
+    {
+#ifdef __linux__
+        data = mremap((void *)mapping->data, (size_t)mapping->size, (size_t)size, MREMAP_MAYMOVE);
+#else
+        data = MAP_FAILED;
+#endif
+        if (data == MAP_FAILED)
+        {
+            data = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                munmap((void *)mapping->data, (size_t)mapping->size);
+            }
+        }
+    }
+    else if (size > 0)
+    {
+        data = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    else
+    {
+        munmap((void *)mapping->data, (size_t)mapping->size);
+    }
+
+    if (data == MAP_FAILED)
+    {
+        // Put the old length back, so the view still covers the whole file
+        if (ftruncate(fd, (off_t)mapping->size) != 0)
+        {
+            printf("Failed to restore the length of host file '%s'.\n", path);
+        }
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    mapping->data = data;
+    mapping->size = size;
+    return 0;
+#endif
+}
+
+// Writes the pages of a writable mapping covering [offset, offset + length) back to the host
+// file and waits for them to reach it
+int flushHostMapping(const struct HostMapping *mapping, uint64_t offset, uint64_t length)
+{
+    if (mapping->data == NULL || length == 0)
+    {
+        return 0;
+    }
+#ifdef _WIN32
+    return FlushViewOfFile(mapping->data + offset, (SIZE_T)length) ? 0 : -1;
+#else
+    // msync wants a page-aligned start
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t start = offset - offset % page;
+    return msync((void *)(mapping->data + start), (size_t)(offset + length - start), MS_SYNC);
+#endif
+}
+
+int openHostDirectory(const char *path, struct HostDirectory *dir)
+{
+#ifdef _WIN32
+    char pattern[MAX_PATH];
+    if (snprintf(pattern, sizeof(pattern), "%s\\*", path) >= (int)sizeof(pattern))
+    {
+        return -1;
+    }
+    dir->find = FindFirstFileA(pattern, &dir->entry);
+    dir->started = 0;
+    return dir->find == INVALID_HANDLE_VALUE ? -1 : 0;
+#else
+    dir->dir = opendir(path);
+    return dir->dir == NULL ? -1 : 0;
+#endif
+}
+
+// Next regular file or directory, skipping "." and "..", anything else, and links to
+// directories, which could lead back up the tree. NULL after the last entry.
+const char *nextHostEntry(struct HostDirectory *dir, int *isDirectory)
+{
+#ifdef _WIN32
+    while (dir->started++ == 0 || FindNextFileA(dir->find, &dir->entry))
+    {
+        const char *name = dir->entry.cFileName;
+        DWORD attributes = dir->entry.dwFileAttributes;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0 || (attributes & FILE_ATTRIBUTE_DEVICE) ||
+            ((attributes & FILE_ATTRIBUTE_DIRECTORY) && (attributes & FILE_ATTRIBUTE_REPARSE_POINT)))
+        {
+            continue;
+        }
+        *isDirectory = (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        return name;
+    }
+#else
+    struct dirent *entry;
+    while ((entry = readdir(dir->dir)) != NULL)
+    {
+        const char *name = entry->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+        {
+            continue;
+        }
+
+        int type = entry->d_type;
+        struct stat info;
+        if (type == DT_UNKNOWN || type == DT_LNK)
+        {
+            if (fstatat(dirfd(dir->dir), name, &info, type == DT_UNKNOWN ? AT_SYMLINK_NOFOLLOW : 0) != 0 ||
+                (type == DT_LNK && S_ISDIR(info.st_mode)))
+            {
+                continue;
+            }
+            type = S_ISDIR(info.st_mode) ? DT_DIR : S_ISREG(info.st_mode) ? DT_REG : DT_UNKNOWN;
+        }
+        if (type == DT_DIR || type == DT_REG)
+        {
+            *isDirectory = type == DT_DIR;
+            return name;
+        }
+    }
+#endif
+    return NULL;
+}
+
+void closeHostDirectory(struct HostDirectory *dir)
+{
+#ifdef _WIN32
+    FindClose(dir->find);
+#else
+    closedir(dir->dir);
+#endif
+}
+
+// Size and modification time of the regular host file at 'path'; -1 if there is none
+int statHostFile(const char *path, uint64_t *size, int64_t *modified)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &info) || (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        return -1;
+    }
+    *size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+    *modified = (int64_t)(((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime);
+#else
+    struct stat info;
+    if (stat(path, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        return -1;
+    }
+    *size = (uint64_t)info.st_size;
+    *modified = hostModifiedTime(&info);
+#endif
+    return 0;
+}
+
+// Whether two host paths name the same file, links included: same device and inode, or on
+// Win32 the same volume and file index. 0 when either is missing.
+int sameHostFile(const char *path, const char *otherPath)
+{
+#ifdef _WIN32
+    BY_HANDLE_FILE_INFORMATION info[2];
+    const char *paths[2] = {path, otherPath};
+    for (int i = 0; i < 2; ++i)
+    {
+        HANDLE hFile = CreateFileA(paths[i], 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
+        {
+            return 0;
+        }
+        BOOL found = GetFileInformationByHandle(hFile, &info[i]);
+        CloseHandle(hFile);
+        if (!found)
+        {
+            return 0;
+        }
+    }
+    return info[0].dwVolumeSerialNumber == info[1].dwVolumeSerialNumber && info[0].nFileIndexHigh == info[1].nFileIndexHigh &&
+           info[0].nFileIndexLow == info[1].nFileIndexLow;
+#else
+    struct stat info;
+    struct stat otherInfo;
+    return stat(path, &info) == 0 && stat(otherPath, &otherInfo) == 0 && info.st_dev == otherInfo.st_dev &&
+           info.st_ino == otherInfo.st_ino;
+#endif
+}
+
+// Creates a host directory; one that already exists is fine
+int createHostDirectory(const char *path)
+{
+#ifdef _WIN32
+    if (CreateDirectoryA(path, NULL))
+    {
+        return 0;
+    }
+    DWORD attributes = GetFileAttributesA(path);
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) ? 0 : -1;
+#else
+    struct stat info;
+    if (mkdir(path, 0755) == 0)
+    {
+        return 0;
+    }
+    return errno == EEXIST && stat(path, &info) == 0 && S_ISDIR(info.st_mode) ? 0 : -1;
+#endif
+}
+
+// Reserves space for a file about to be written, so the file system can lay it out in one
+// piece. Only a hint: the file size does not change, and where the host cannot do it cheaply
+// nothing happens.
+void preallocateHostFile(PlatformFile file, uint64_t size)
+{
+#ifdef _WIN32
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = (LONGLONG)size;
+    SetFileInformationByHandle(file, FileAllocationInfo, &info, sizeof(info));
+#elif defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    if (size > 0)
+    {
+        fallocate(file, FALLOC_FL_KEEP_SIZE, 0, (off_t)size);
+    }
+#else
+    (void)file;
+    (void)size;
+#endif
+}
+
+// Creates or truncates a host file for writing
+int createHostFile(const char *path, PlatformFile *file)
+{
+#ifdef _WIN32
+    *file = CreateFile(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    return *file == INVALID_HANDLE_VALUE ? -1 : 0;
+#else
+    *file = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    return *file < 0 ? -1 : 0;
+#endif
+}
+
+// Writes all of 'data', in as many calls as the OS needs
+int writeHostFile(PlatformFile file, const void *data, uint64_t length)
+{
+    const char *bytes = data;
+    while (length > 0)
+    {
+#ifdef _WIN32
+        DWORD chunk = length > (1u << 30) ? (1u << 30) : (DWORD)length;
+        DWORD written;
+        if (!WriteFile(file, bytes, chunk, &written, NULL) || written == 0)
+        {
+            return -1;
+        }
+#else
+        size_t chunk = length > (1u << 30) ? (1u << 30) : (size_t)length;
+        ssize_t written = write(file, bytes, chunk);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return -1;
+        }
+#endif
+        bytes += written;
+        length -= (uint64_t)written;
+    }
+    return 0;
+}
+
+void closeHostFile(PlatformFile file)
+{
+#ifdef _WIN32
+    CloseHandle(file);
+#else
+    close(file);
+#endif
+}
+
+// Runs one request with blocking calls
+static void runHostIoRequest(struct HostIoRequest *request)
+{
+    switch (request->op)
+    {
+    case HOST_IO_OPEN_READ:
+    case HOST_IO_OPEN_WRITE:
+#ifdef _WIN32
+        request->file = request->op == HOST_IO_OPEN_READ
+                            ? CreateFileA(request->path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL)
+                            : CreateFileA(request->path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        request->failed = request->file == INVALID_HANDLE_VALUE;
+#else
+        request->file = request->op == HOST_IO_OPEN_READ ? open(request->path, O_RDONLY | O_CLOEXEC)
+                                                         : open(request->path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        request->failed = request->file < 0;
+#endif
+        break;
+    case HOST_IO_SIZE:
+    {
+        int64_t modified;
+        request->failed = statHostFile(request->path, &request->length, &modified) != 0;
+        break;
+    }
+    case HOST_IO_READ:
+    case HOST_IO_WRITE:
+        while (request->done < request->length)
+        {
+            uint64_t remaining = request->length - request->done;
+            char *bytes = (char *)request->buffer + request->done;
+#ifdef _WIN32
+            DWORD chunk = remaining > (1u << 30) ? (1u << 30) : (DWORD)remaining;
+            DWORD moved = 0;
+            OVERLAPPED position;
+            memset(&position, 0, sizeof(position));
+            position.Offset = (DWORD)(request->offset + request->done);
+            position.OffsetHigh = (DWORD)((request->offset + request->done) >> 32);
+            BOOL ok = request->op == HOST_IO_READ ? ReadFile(request->file, bytes, chunk, &moved, &position)
+                                                  : WriteFile(request->file, bytes, chunk, &moved, &position);
+            if (!ok && GetLastError() != ERROR_HANDLE_EOF)
+            {
+                request->failed = 1;
+                break;
+            }
+#else
+            size_t chunk = remaining > (1u << 30) ? (1u << 30) : (size_t)remaining;
+            off_t offset = (off_t)(request->offset + request->done);
+            ssize_t moved = request->op == HOST_IO_READ ? pread(request->file, bytes, chunk, offset)
+                                                        : pwrite(request->file, bytes, chunk, offset);
+            if (moved < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (moved < 0)
+            {
+                request->failed = 1;
+                break;
+            }
+#endif
+            if (moved == 0)
+            {
+                request->failed = request->op == HOST_IO_WRITE;
+                break;
+            }
+            request->done += (uint64_t)moved;
+        }
+        break;
+    case HOST_IO_PREALLOCATE:
+        preallocateHostFile(request->file, request->length);
+        break;
+    case HOST_IO_CLOSE:
+        closeHostFile(request->file);
+        break;
+    }
+}
+#ifdef FSYS_HAVE_URING
+static int uringEnter(int ringFd, unsigned submit, unsigned wait)
+{
+    return (int)syscall(__NR_io_uring_enter, ringFd, submit, wait, IORING_ENTER_GETEVENTS, NULL, 0);
+}
+
+// Every operation the batches use must be there; kernels before 5.6 lack most of them
+static int uringSupportsBatches(int ringFd)
+{
+    static const int needed[] = {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_FALLOCATE, IORING_OP_CLOSE};
+    size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, size);
+    int supported = probe != NULL && syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, 256) == 0;
+    for (size_t i = 0; supported && i < sizeof(needed) / sizeof(needed[0]); ++i)
+    {
+        supported = needed[i] <= probe->last_op && (probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED);
+    }
+    free(probe);
+    return supported;
+}
+
+static void uringPrepare(struct io_uring_sqe *sqe, struct HostIoRequest *request, size_t index, struct statx *sizes)
+{
+    uint64_t remaining = request->length - request->done;
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->user_data = index;
+    switch (request->op)
+    {
+    case HOST_IO_OPEN_READ:
+    case HOST_IO_OPEN_WRITE:
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (uintptr_t)request->path;
+        sqe->len = 0644;
+        sqe->open_flags = request->op == HOST_IO_OPEN_READ ? O_RDONLY | O_CLOEXEC : O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        break;
+    case HOST_IO_SIZE:
+        sqe->opcode = IORING_OP_STATX;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (uintptr_t)request->path;
+        sqe->len = STATX_SIZE | STATX_TYPE;
+        sqe->off = (uintptr_t)&sizes[index];
+        break;
+    case HOST_IO_READ:
+    case HOST_IO_WRITE:
+        sqe->opcode = request->op == HOST_IO_READ ? IORING_OP_READ : IORING_OP_WRITE;
+        sqe->fd = request->file;
+        sqe->addr = (uintptr_t)((char *)request->buffer + request->done);
+        sqe->len = remaining > (1u << 30) ? (1u << 30) : (unsigned)remaining;
+        sqe->off = request->offset + request->done;
+        break;
+    case HOST_IO_PREALLOCATE:
+        sqe->opcode = IORING_OP_FALLOCATE;
+        sqe->fd = request->file;
+        sqe->len = FALLOC_FL_KEEP_SIZE;
+        sqe->addr = request->length;
+        break;
+    case HOST_IO_CLOSE:
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = request->file;
+        break;
+    }
+}
+
+// Applies a completion; nonzero when a short read or write has to go out again for the rest.
+// A request only loses its failed mark here, once it has completed for good.
+static int uringComplete(struct HostIoRequest *request, int result, const struct statx *size)
+{
+    switch (request->op)
+    {
+    case HOST_IO_OPEN_READ:
+    case HOST_IO_OPEN_WRITE:
+        request->file = result;
+        request->failed = result < 0;
+        return 0;
+    case HOST_IO_SIZE:
+        request->failed = result < 0 || !S_ISREG(size->stx_mode);
+        request->length = result < 0 ? 0 : size->stx_size;
+        return 0;
+    case HOST_IO_READ:
+    case HOST_IO_WRITE:
+        if (result == -EINTR || result == -EAGAIN)
+        {
+            return 1;
+        }
+        if (result > 0)
+        {
+            request->done += (uint64_t)result;
+            if (request->done < request->length)
+            {
+                return 1;
+            }
+        }
+        request->failed = result < 0 || (request->op == HOST_IO_WRITE && request->done < request->length);
+        return 0;
+    default:
+        request->failed = 0; // Preallocation is a hint, and a failed close leaves nothing to do
+        return 0;
+    }
+}
+
+// Puts as many requests as fit in the submission ring, then submits them and waits for all of
+// their completions with a single io_uring_enter where it can. Requests that need another round
+// are gathered back into 'pending'; returns how many there are, or -1 if the ring failed. A
+// failed ring is drained of everything the kernel took from it first, so no request is still in
+// flight when the caller frees its buffers; if even that fails, those requests are marked lost.
+static long uringRound(struct HostIoQueue *queue, struct HostIoRequest *requests, size_t *pending, size_t pendingCount,
+                       struct statx *sizes)
+{
+    struct io_uring_sqe *sqes = queue->sqes;
+    struct io_uring_cqe *cqes = queue->cqes;
+    unsigned count = pendingCount < queue->entries ? (unsigned)pendingCount : queue->entries;
+    unsigned first = *queue->sq_tail;
+    unsigned tail = first;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        unsigned slot = tail & *queue->sq_mask;
+        uringPrepare(&sqes[slot], &requests[pending[i]], pending[i], sizes);
+        requests[pending[i]].lost = 1;
+        queue->sq_array[slot] = slot;
+        tail++;
+    }
+    __atomic_store_n(queue->sq_tail, tail, __ATOMIC_RELEASE);
+
+    size_t again = 0;
+    unsigned submitted = 0;
+    unsigned completed = 0;
+    int failed = 0;
+    while (completed < count)
+    {
+        if (!failed)
+        {
+            int entered = uringEnter(queue->ring_fd, count - submitted, count - completed);
+            queue->system_calls++;
+            failed = entered < 0 && errno != EINTR;
+            submitted += entered > 0 ? (unsigned)entered : 0;
+        }
+        if (failed)
+        {
+            // Only wait for what the kernel has taken; the rest never leaves the ring
+            unsigned taken = __atomic_load_n(queue->sq_head, __ATOMIC_ACQUIRE) - first;
+            if (completed >= taken)
+            {
+                break;
+            }
+            queue->system_calls++;
+            if (uringEnter(queue->ring_fd, 0, taken - completed) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                return -1;
+            }
+        }
+
+        unsigned head = *queue->cq_head;
+        while (head != __atomic_load_n(queue->cq_tail, __ATOMIC_ACQUIRE))
+        {
+            const struct io_uring_cqe *cqe = &cqes[head & *queue->cq_mask];
+            size_t index = (size_t)cqe->user_data;
+            requests[index].lost = 0;
+            if (uringComplete(&requests[index], cqe->res, &sizes[index]))
+            {
+                pending[again++] = index;
+            }
+            head++;
+            completed++;
+        }
+        __atomic_store_n(queue->cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    if (failed)
+    {
+        // Everything taken has completed, and what is left in the ring is never submitted
+        for (unsigned i = 0; i < count; ++i)
+        {
+            requests[sqes[(first + i) & *queue->sq_mask].user_data].lost = 0;
+        }
+        return -1;
+    }
+
+    // Requests that did not fit this round go after the ones to retry
+    memmove(pending + again, pending + count, sizeof(size_t) * (pendingCount - count));
+    return (long)(again + pendingCount - count);
+}
+#endif
+
+// Sets up a queue that keeps up to 'depth' requests in flight. Without io_uring, or with
+// 'useUring' clear, requests run one at a time as blocking calls. Returns whether io_uring is used.
+int initHostIoQueue(struct HostIoQueue *queue, unsigned depth, int useUring)
+{
+    memset(queue, 0, sizeof(struct HostIoQueue));
+    queue->ring_fd = -1;
+#ifdef FSYS_HAVE_URING
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int ringFd = useUring ? (int)syscall(__NR_io_uring_setup, depth > 0 ? depth : 1, &params) : -1;
+    if (ringFd < 0)
+    {
+        return 0;
+    }
+
+    queue->ring_fd = ringFd;
+    queue->entries = params.sq_entries;
+    queue->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    queue->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    int single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && queue->cq_ring_size > queue->sq_ring_size)
+    {
+        queue->sq_ring_size = queue->cq_ring_size;
+    }
+    queue->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    void *sqRing = mmap(NULL, queue->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    void *cqRing = single || sqRing == MAP_FAILED ? sqRing
+                                                  : mmap(NULL, queue->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    void *sqes = cqRing == MAP_FAILED ? MAP_FAILED
+                                      : mmap(NULL, queue->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    queue->sq_ring = sqRing != MAP_FAILED ? sqRing : NULL;
+    queue->cq_ring = cqRing != MAP_FAILED ? cqRing : NULL;
+    queue->sqes = sqes != MAP_FAILED ? sqes : NULL;
+    if (queue->sqes == NULL || !uringSupportsBatches(ringFd))
+    {
+        freeHostIoQueue(queue);
+        return 0;
+    }
+
+    queue->sq_head = (unsigned *)((char *)sqRing + params.sq_off.head);
+    queue->sq_tail = (unsigned *)((char *)sqRing + params.sq_off.tail);
+    queue->sq_mask = (unsigned *)((char *)sqRing + params.sq_off.ring_mask);
+    queue->sq_array = (unsigned *)((char *)sqRing + params.sq_off.array);
+    queue->cq_head = (unsigned *)((char *)cqRing + params.cq_off.head);
+    queue->cq_tail = (unsigned *)((char *)cqRing + params.cq_off.tail);
+    queue->cq_mask = (unsigned *)((char *)cqRing + params.cq_off.ring_mask);
+    queue->cqes = (char *)cqRing + params.cq_off.cqes;
+    queue->uring = 1;
+#else
+    (void)depth;
+    (void)useUring;
+#endif
+    return queue->uring;
+}
+
+// Runs every request to completion. Requests are independent and may finish in any order, so a
+// request that depends on another (a read on a file being opened) goes in a later call.
+void runHostIo(struct HostIoQueue *queue, struct HostIoRequest *requests, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        requests[i].done = 0;
+        requests[i].failed = 0;
+        requests[i].lost = 0;
+    }
+    queue->operations += count;
+
+#ifdef FSYS_HAVE_URING
+    int sizing = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        sizing |= requests[i].op == HOST_IO_SIZE;
+    }
+    size_t *pending = queue->uring ? malloc(sizeof(size_t) * count) : NULL;
+    struct statx *sizes = pending != NULL && sizing ? malloc(sizeof(struct statx) * count) : NULL;
+    if (pending != NULL && (sizes != NULL || !sizing))
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            pending[i] = i;
+            requests[i].failed = 1;
+        }
+        long pendingCount = (long)count;
+        while (pendingCount > 0)
+        {
+            pendingCount = uringRound(queue, requests, pending, (size_t)pendingCount, sizes);
+        }
+        free(pending);
+
+        // If the ring itself failed, give it up, leaving the requests that never completed
+        // failed, and use blocking calls from now on. A lost statx may still write its size.
+        int lost = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            lost |= requests[i].lost;
+        }
+        if (!lost)
+        {
+            free(sizes);
+        }
+        if (pendingCount < 0)
+        {
+            freeHostIoQueue(queue);
+        }
+        return;
+    }
+    free(pending);
+#endif
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        runHostIoRequest(&requests[i]);
+        queue->system_calls++;
+    }
+}
+
+void freeHostIoQueue(struct HostIoQueue *queue)
+{
+#ifdef FSYS_HAVE_URING
+    if (queue->sqes != NULL)
+    {
+        munmap(queue->sqes, queue->sqes_size);
+    }
+    if (queue->cq_ring != NULL && queue->cq_ring != queue->sq_ring)
+    {
+        munmap(queue->cq_ring, queue->cq_ring_size);
+    }
+    if (queue->sq_ring != NULL)
+    {
+        munmap(queue->sq_ring, queue->sq_ring_size);
+    }
+    if (queue->ring_fd >= 0)
+    {
+        close(queue->ring_fd);
+    }
+#endif
+    queue->uring = 0;
+    queue->ring_fd = -1;
+    queue->sq_ring = NULL;
+    queue->cq_ring = NULL;
+    queue->sqes = NULL;
+}
+
+// Appends the host file at 'sourcePath' to 'target' inside the kernel, so its bytes never pass
+// through user memory: copy_file_range where the file systems allow it, sendfile otherwise.
+// The source must still have the size and modification time in 'expected'. Returns the bytes
+// copied, which the caller continues from; 0 when the host has no such copy (Win32) or the
+// source changed, and 'method' then keeps its value.
+uint64_t copyHostFile(PlatformFile target, const char *sourcePath, const struct HostMapping *expected, const char **method)
+{
+    uint64_t copied = 0;
+#ifdef __linux__
+    int source = open(sourcePath, O_RDONLY | O_CLOEXEC);
+    if (source < 0)
+    {
+        return 0;
+    }
+
+    struct stat info;
+    if (fstat(source, &info) != 0 || (uint64_t)info.st_size != expected->size || hostModifiedTime(&info) != expected->modified)
+    {
+        close(source);
+        return 0;
+    }
+
+    int useSendfile = 0;
+    while (copied < expected->size)
+    {
+        size_t chunk = expected->size - copied > (1u << 30) ? (1u << 30) : (size_t)(expected->size - copied);
+        ssize_t done = useSendfile ? sendfile(target, source, NULL, chunk) : copy_file_range(source, NULL, target, NULL, chunk, 0);
+        if (done < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (done < 0 && !useSendfile && copied == 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP))
+        {
+            useSendfile = 1;
+            continue;
+        }
+        if (done <= 0)
+        {
+            break;
+        }
+        copied += (uint64_t)done;
+    }
+    close(source);
+
+    if (copied > 0)
+    {
+        *method = useSendfile ? "sendfile" : "copy_file_range";
+    }
+#else
+    (void)target;
+    (void)sourcePath;
+    (void)expected;
+    (void)method;
+#endif
+    return copied;
+}
+
 int isWhitespaceString(const char *str)
 {
-    if (str == NULL)
+    if (str == NULL)
+    {
+        return 1;
+    }
+
+    int charCount = 0;
+    while (*str != '\0')
+    {
+        if (charCount >= MAX_CHARS)
+        {
+            printf("Exceeded maximum character count (%d).\n", MAX_CHARS);
+            return 0;
+        }
+
+        if (!isspace((unsigned char)*str))
+        {
+            return 0;
+        }
+        str++;
+        charCount++;
+    }
+
+    return 1;
+}
+
+void addUserToSystem(struct FileSystem *fs, const char *username,
+                     const char *password, enum AuthorityLevel accessLevel)
+{
+    if (username == NULL || isWhitespaceString(username) || strlen(username) >= MAX_USERNAME_LENGTH ||
+        password == NULL || strlen(password) >= MAX_PASSWORD_LENGTH)
+    {
+        printf("Invalid or too long username or password provided.\n");
+        return;
+    }
+
+    if (fs->user_count < MAX_USERS)
+    {
+        strncpy(fs->users[fs->user_count].username, username, MAX_USERNAME_LENGTH - 1);
+        strncpy(fs->users[fs->user_count].password, password, MAX_PASSWORD_LENGTH - 1);
+        fs->users[fs->user_count].access_level = accessLevel;
+        fs->user_count++;
+        printf("User added successfully.\n");
+    }
+    else
+    {
+        printf("Cannot add more users. Maximum capacity reached.\n");
+    }
+}
+
+void deleteUserFromSystem(struct FileSystem *fs, const char *username)
+{
+    if (username == NULL || isWhitespaceString(username) || strlen(username) >= MAX_USERNAME_LENGTH)
+    {
+        printf("Invalid or too long username provided.\n");
+        return;
+    }
+
+    int found = 0;
+    for (int i = 0; i < fs->user_count; ++i)
+    {
+        if (strcmp(username, fs->users[i].username) == 0)
+        {
+            found = 1;
+            // Shift elements in the array starting from the found index
+            for (int j = i; j < fs->user_count - 1; ++j)
+            {
+                strcpy(fs->users[j].username, fs->users[j + 1].username);
+                strcpy(fs->users[j].password, fs->users[j + 1].password);
+                fs->users[j].access_level = fs->users[j + 1].access_level;
+            }
+            // Clear the last element in the array
+            memset(&fs->users[fs->user_count - 1], 0, sizeof(struct User));
+            fs->user_count--;
+            printf("User '%s' deleted successfully.\n", username);
+            break;
+        }
+    }
+
+    if (!found)
+    {
+        printf("User '%s' not found in the system.\n", username);
+    }
+}
+
+void startTimerForUser(struct Timer *timer, int delaySeconds)
+{
+    timer->startTime = time(NULL);
+    timer->delayDuration = delaySeconds;
+}
+
+int isUserTimerExpired(struct Timer *timer)
+{
+    time_t currentTime = time(NULL);
+    return (currentTime - timer->startTime >= timer->delayDuration);
+}
+
+struct User loginUser(struct FileSystem *fs, const char *username)
+{
+    if (fs == NULL || username == NULL || isWhitespaceString(username))
+    {
+        printf("Invalid parameters provided for login.\n");
+        struct User emptyUser = {"", "", LOW, 0}; // Return an empty user if login fails
+        return emptyUser;
+    }
+
+    if (strlen(username) >= MAX_USERNAME_LENGTH)
+    {
+        printf("Username length exceeds maximum limit.\n");
+        struct User emptyUser = {"", "", LOW, 0}; // Return an empty user if login fails
+        return emptyUser;
+    }
+
+    struct User *currentUser = NULL;
+
+    for (int i = 0; i < fs->user_count; ++i)
+    {
+        if (strcmp(username, fs->users[i].username) == 0)
+        {
+            currentUser = &fs->users[i];
+            break;
+        }
+    }
+
+    if (currentUser != NULL)
+    {
+        for (int i = 0; i < currentUser->delayParams.delayedUsersCount; ++i)
+        {
+            if (isUserTimerExpired(&(currentUser->delayParams.delayedUsers[i].timer)))
+            {
+                currentUser->delayParams.delayedUsers[i].penaltyDelaySeconds = 0;
+            }
+        }
+
+        int totalDelay = 0;
+        for (int i = 0; i < currentUser->delayParams.delayedUsersCount; ++i)
+        {
+            totalDelay += currentUser->delayParams.delayedUsers[i].penaltyDelaySeconds;
+        }
+
+        if (totalDelay > 0)
+        {
+            printf("Login failed. Users are delayed. Retry after %d seconds.\n", totalDelay);
+            struct User emptyUser = {"", "", LOW, 0};
+            return emptyUser;
+        }
+
+        printf("Enter password: ");
+        char password[MAX_PASSWORD_LENGTH];
+        int index = 0;
+        char ch;
+        while ((ch = readConsoleKey()) != '\r' && index < MAX_PASSWORD_LENGTH - 1)
+        {
+            if (ch == '\b' && index > 0)
+            {
+                printf("\b \b");
+                index--;
+            }
+            else if (ch != '\b')
+            {
+                printf("*");
+                password[index++] = ch;
+            }
+        }
+        password[index] = '\0';
+        printf("\n");
+
+        if (strcmp(password, currentUser->password) == 0)
+        {
+            printf("Logged in successfully as %s with level %d.\n", username, currentUser->access_level);
+            currentUser->login_attempts = 0; // Reset login attempts
+            // Update the current user in the file system
+            fs->current_user = *currentUser;
+            // Return the logged-in user
+            return *currentUser;
+        }
+        else
+        {
+            currentUser->login_attempts++;
+
+            int attempts = currentUser->login_attempts;
+
+            if (attempts % 3 == 0)
+            {
+                int penaltyDelay = (attempts / 3) * BASE_DELAY_SECONDS;
+                currentUser->delayParams.delayedUsers[currentUser->delayParams.delayedUsersCount].penaltyDelaySeconds = penaltyDelay;
+                startTimerForUser(&(currentUser->delayParams.delayedUsers[currentUser->delayParams.delayedUsersCount].timer), penaltyDelay);
+                strcpy(currentUser->delayParams.delayedUsers[currentUser->delayParams.delayedUsersCount].username, username);
+                currentUser->delayParams.delayedUsersCount++;
+                printf("Too many failed login attempts for user '%s'. Retry after %d seconds.\n", username, penaltyDelay);
+            }
+            else
+            {
+                printf("Login failed. Invalid username or password. Attempt %d.\n", attempts);
+            }
+        }
+    }
+    else
+    {
+        printf("Login failed. Invalid username.\n");
+    }
+
+    struct User emptyUser = {"", "", LOW, 0};
+    return emptyUser;
+}
+
+void resetPassword(struct FileSystem *fs, const char *username)
+{
+    if (fs == NULL || username == NULL || isWhitespaceString(username))
+    {
+        printf("Invalid parameters provided for password reset.\n");
+        return;
+    }
+
+    if (strlen(username) >= MAX_USERNAME_LENGTH)
+    {
+        printf("Username length exceeds maximum limit.\n");
+        return;
+    }
+
+    struct User *currentUser = NULL;
+
+    for (int i = 0; i < fs->user_count; ++i)
+    {
+        if (strcmp(username, fs->users[i].username) == 0)
+        {
+            currentUser = &fs->users[i];
+            break;
+        }
+    }
+
+    if (currentUser != NULL)
+    {
+        for (int i = 0; i < currentUser->delayParams.delayedUsersCount; ++i)
+        {
+            if (isUserTimerExpired(&(currentUser->delayParams.delayedUsers[i].timer)))
+            {
+                currentUser->delayParams.delayedUsers[i].penaltyDelaySeconds = 0;
+            }
+        }
+
+        int totalDelay = 0;
+        for (int i = 0; i < currentUser->delayParams.delayedUsersCount; ++i)
+        {
+            totalDelay += currentUser->delayParams.delayedUsers[i].penaltyDelaySeconds;
+        }
+
+        if (totalDelay > 0)
+        {
+            printf("Too many failed password reset attempts. Retry after %d seconds.\n", totalDelay);
+            struct User emptyUser = {"", "", LOW, 0};
+            return;
+        }
+
+        printf("Enter old password: ");
+        char oldPassword[MAX_PASSWORD_LENGTH];
+        int index = 0;
+        char ch;
+        while ((ch = readConsoleKey()) != '\r' && index < MAX_PASSWORD_LENGTH - 1)
+        {
+            if (ch == '\b' && index > 0)
+            {
+                printf("\b \b");
+                index--;
+            }
+            else if (ch != '\b')
+            {
+                printf("*");
+                oldPassword[index++] = ch;
+            }
+        }
+        oldPassword[index] = '\0';
+        printf("\n");
+
+        if (strcmp(oldPassword, currentUser->password) != 0)
+        {
+            currentUser->login_attempts++;
+
+            int attempts = currentUser->login_attempts;
+            if (attempts % 3 == 0)
+            {
+                int penaltyDelay = (attempts / 3) * BASE_DELAY_SECONDS;
+                currentUser->delayParams.delayedUsers[currentUser->delayParams.delayedUsersCount].penaltyDelaySeconds = penaltyDelay;
+                startTimerForUser(&(currentUser->delayParams.delayedUsers[currentUser->delayParams.delayedUsersCount].timer), penaltyDelay);
+                strcpy(currentUser->delayParams.delayedUsers[currentUser->delayParams.delayedUsersCount].username, username);
+                currentUser->delayParams.delayedUsersCount++;
+                printf("Too many failed password reset attempts. Retry after %d seconds.\n", penaltyDelay);
+            }
+            else
+            {
+                printf("Password reset failed. Attempt %d.\n", attempts);
+            }
+            return;
+        }
+
+        printf("Enter new password: ");
+        char newPassword[MAX_PASSWORD_LENGTH];
+        index = 0;
+        while ((ch = readConsoleKey()) != '\r' && index < MAX_PASSWORD_LENGTH - 1)
+        {
+            if (ch == '\b' && index > 0)
+            {
+                printf("\b \b");
+                index--;
+            }
+            else if (ch != '\b')
+            {
+                printf("*");
+                newPassword[index++] = ch;
+            }
+        }
+        newPassword[index] = '\0';
+        printf("\n");
+
+        printf("Enter new password again for verification: ");
+        char newPasswordVerify[MAX_PASSWORD_LENGTH];
+        index = 0;
+        while ((ch = readConsoleKey()) != '\r' && index < MAX_PASSWORD_LENGTH - 1)
+        {
+            if (ch == '\b' && index > 0)
+            {
+                printf("\b \b");
+                index--;
+            }
+            else if (ch != '\b')
+            {
+                printf("*");
+                newPasswordVerify[index++] = ch;
+            }
+        }
+        newPasswordVerify[index] = '\0';
+        printf("\n");
+
+        if (strcmp(newPassword, newPasswordVerify) != 0)
+        {
+            printf("Passwords do not match. Password reset failed.\n");
+            return;
+        }
+
+        strncpy(currentUser->password, newPassword, MAX_PASSWORD_LENGTH - 1);
+        printf("Password reset successfully for user %s.\n", username);
+
+        if (strcmp(fs->current_user.username, username) == 0)
+        {
+            strncpy(fs->current_user.password, newPassword, MAX_PASSWORD_LENGTH - 1);
+        }
+
+        currentUser->login_attempts = 0;
+    }
+    else
+    {
+        printf("User not found.\n");
+    }
+}
+
+void initUser(struct User *user)
+{
+    if (user != NULL)
+    {
+        memset(user->username, 0, MAX_USERNAME_LENGTH);
+        memset(user->password, 0, MAX_PASSWORD_LENGTH);
+        user->access_level = LOW;
+        user->login_attempts = 0;
+
+        user->delayParams.delayedUsersCount = 0; // Reset delayed users count
+        for (int i = 0; i < MAX_DELAYED_USERS; ++i)
+        {
+            memset(user->delayParams.delayedUsers[i].username, 0, MAX_USERNAME_LENGTH);
+            user->delayParams.delayedUsers[i].penaltyDelaySeconds = 0;
+        }
+    }
+}
+
+void initFile(struct File *file)
+{
+    if (file != NULL)
+    {
+        file->id = INODE_NONE;
+        file->name_pos = INODE_NONE;
+        file->trigram_epoch = 0;
+        file->trigram_count = 0;
+        file->size = 0;
+        file->content = NULL;
+        file->small = NULL;
+    }
+}
+
+void initDirectory(struct Directory *dir)
+{
+    if (dir != NULL)
+    {
+        dir->id = INODE_NONE;
+        dir->access = LOW;
+        dir->content_indexed = 0;
+        dir->compressed = 0;
+        initChildIndex(&dir->files);
+        initChildIndex(&dir->subdirectories);
+    }
+}
+
+#define CHILD_INDEX_MIN_SLOTS 8
+
+unsigned int hashName(const char *name)
+{
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    while (*name != '\0')
+    {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void initChildIndex(struct ChildIndex *index)
+{
+    index->ids = NULL;
+    index->count = 0;
+    index->capacity = 0;
+    index->slots = NULL;
+    index->slot_count = 0;
+    index->sorted = 1;
+}
+
+void freeChildIndex(struct ChildIndex *index)
+{
+    free(index->ids);
+    free(index->slots);
+    initChildIndex(index);
+}
+
+// Returns the slot holding 'name', or the empty slot where it would go
+static int childIndexProbe(const struct InodeTable *table, const struct ChildIndex *index, const char *name)
+{
+    int mask = index->slot_count - 1;
+    int slot = (int)(hashName(name) & (unsigned int)mask);
+
+    while (index->slots[slot] != -1 && strcmp(table->names[index->ids[index->slots[slot]]], name) != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void childIndexFillSlots(const struct InodeTable *table, struct ChildIndex *index)
+{
+    memset(index->slots, 0xff, sizeof(int) * index->slot_count);
+    for (int i = 0; i < index->count; ++i)
+    {
+        index->slots[childIndexProbe(table, index, table->names[index->ids[i]])] = i;
+    }
+}
+
+uint32_t childIndexFind(const struct InodeTable *table, const struct ChildIndex *index, const char *name)
+{
+    if (index->count == 0)
+    {
+        return INODE_NONE;
+    }
+
+    int pos = index->slots[childIndexProbe(table, index, name)];
+    return pos == -1 ? INODE_NONE : index->ids[pos];
+}
+
+int childIndexInsert(const struct InodeTable *table, struct ChildIndex *index, uint32_t id)
+{
+    const char *name = table->names[id];
+
+    if (childIndexFind(table, index, name) != INODE_NONE)
+    {
+        return -1;
+    }
+
+    if (index->count == index->capacity)
+    {
+        int capacity = index->capacity > 0 ? index->capacity * 2 : CHILD_INDEX_MIN_SLOTS / 2;
+        uint32_t *ids = realloc(index->ids, sizeof(uint32_t) * capacity);
+        if (ids == NULL)
+        {
+            return -2;
+        }
+        index->ids = ids;
+        index->capacity = capacity;
+    }
+
+    // Keep the table at most half full
+    if ((index->count + 1) * 2 > index->slot_count)
+    {
+        int slotCount = index->slot_count > 0 ? index->slot_count * 2 : CHILD_INDEX_MIN_SLOTS;
+        int *slots = realloc(index->slots, sizeof(int) * slotCount);
+        if (slots == NULL)
+        {
+            return -2;
+        }
+        index->slots = slots;
+        index->slot_count = slotCount;
+        childIndexFillSlots(table, index);
+    }
+
+    // Appending past the last name keeps a sorted index sorted
+    if (index->count > 0 && strcmp(table->names[index->ids[index->count - 1]], name) > 0)
+    {
+        index->sorted = 0;
+    }
+
+    index->ids[index->count] = id;
+    index->slots[childIndexProbe(table, index, name)] = index->count;
+    index->count++;
+    return 0;
+}
+
+uint32_t childIndexRemove(const struct InodeTable *table, struct ChildIndex *index, const char *name)
+{
+    if (index->count == 0)
+    {
+        return INODE_NONE;
+    }
+
+    int mask = index->slot_count - 1;
+    int slot = childIndexProbe(table, index, name);
+    int pos = index->slots[slot];
+    if (pos == -1)
+    {
+        return INODE_NONE;
+    }
+
+    uint32_t id = index->ids[pos];
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    int hole = slot;
+    int next = (slot + 1) & mask;
+    while (index->slots[next] != -1)
+    {
+        int home = (int)(hashName(table->names[index->ids[index->slots[next]]]) & (unsigned int)mask);
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            index->slots[hole] = index->slots[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    index->slots[hole] = -1;
+
+    // Fill the gap with the last id and repoint its slot
+    int last = index->count - 1;
+    if (pos != last)
+    {
+        index->ids[pos] = index->ids[last];
+        index->slots[childIndexProbe(table, index, table->names[index->ids[pos]])] = pos;
+        index->sorted = 0;
+    }
+    index->count--;
+    return id;
+}
+
+struct ChildSortKey
+{
+    const char *name;
+    uint32_t id;
+};
+
+static int compareChildSortKeys(const void *a, const void *b)
+{
+    return strcmp(((const struct ChildSortKey *)a)->name, ((const struct ChildSortKey *)b)->name);
+}
+
+void childIndexSort(const struct InodeTable *table, struct ChildIndex *index)
+{
+    if (index->sorted)
+    {
+        return;
+    }
+
+    struct ChildSortKey *keys = malloc(sizeof(struct ChildSortKey) * index->count);
+    if (keys == NULL)
+    {
+        return;
+    }
+
+    for (int i = 0; i < index->count; ++i)
+    {
+        keys[i].name = table->names[index->ids[i]];
+        keys[i].id = index->ids[i];
+    }
+    qsort(keys, index->count, sizeof(struct ChildSortKey), compareChildSortKeys);
+    for (int i = 0; i < index->count; ++i)
+    {
+        index->ids[i] = keys[i].id;
+    }
+    free(keys);
+
+    childIndexFillSlots(table, index);
+    index->sorted = 1;
+}
+
+// Copies a name to the end of the last block, starting a new block when it is full
+static char *stringHeapStore(struct StringHeap *heap, const char *name, size_t length)
+{
+    if (heap->block_count == 0 || heap->block_used + length > STRING_HEAP_BLOCK_SIZE)
+    {
+        char **blocks = realloc(heap->blocks, sizeof(char *) * (heap->block_count + 1));
+        if (blocks == NULL)
+        {
+            return NULL;
+        }
+        heap->blocks = blocks;
+
+        heap->blocks[heap->block_count] = calloc(1, STRING_HEAP_BLOCK_SIZE);
+        if (heap->blocks[heap->block_count] == NULL)
+        {
+            return NULL;
+        }
+        heap->block_count++;
+        heap->block_used = 0;
+    }
+
+    char *copy = heap->blocks[heap->block_count - 1] + heap->block_used;
+    memcpy(copy, name, length);
+    heap->block_used += length;
+    return copy;
+}
+
+// Returns the slot holding 'name', or the empty slot where it would go
+static size_t stringHeapSlot(const struct StringHeap *heap, const char *name)
+{
+    size_t mask = heap->slot_count - 1;
+    size_t slot = hashName(name) & mask;
+    while (heap->slots[slot].name != NULL && strcmp(heap->slots[slot].name, name) != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Returns the shared copy of 'name', adding it if needed; each call takes a reference
+// that releaseName gives back
+const char *internName(struct StringHeap *heap, const char *name)
+{
+    // Keep the intern table at most half full
+    if ((heap->name_count + 1) * 2 > heap->slot_count)
+    {
+        size_t slotCount = heap->slot_count > 0 ? heap->slot_count * 2 : 1024;
+        struct InternedName *slots = calloc(slotCount, sizeof(struct InternedName));
+        if (slots == NULL)
+        {
+            return NULL;
+        }
+
+        struct StringHeap grown = *heap;
+        grown.slots = slots;
+        grown.slot_count = slotCount;
+        for (size_t i = 0; i < heap->slot_count; ++i)
+        {
+            if (heap->slots[i].name != NULL)
+            {
+                slots[stringHeapSlot(&grown, heap->slots[i].name)] = heap->slots[i];
+            }
+        }
+
+        free(heap->slots);
+        heap->slots = slots;
+        heap->slot_count = slotCount;
+    }
+
+    struct InternedName *slot = &heap->slots[stringHeapSlot(heap, name)];
+    if (slot->name != NULL)
+    {
+        heap->intern_hits++;
+        slot->refs++;
+        return slot->name;
+    }
+
+    size_t length = strlen(name) + 1;
+    const char *copy = stringHeapStore(heap, name, length);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    heap->bytes_used += length;
+    heap->name_count++;
+    slot->name = copy;
+    slot->refs = 1;
+    return copy;
+}
+
+// Drops a reference taken by internName. The last one zeroes the name in its block, so
+// scans over the blocks never see it, and leaves the room for compactNames.
+void releaseName(struct StringHeap *heap, const char *name)
+{
+    if (name == NULL || heap->slot_count == 0)
+    {
+        return;
+    }
+
+    size_t slot = stringHeapSlot(heap, name);
+    if (heap->slots[slot].name != name || --heap->slots[slot].refs > 0)
+    {
+        return;
+    }
+
+    size_t length = strlen(name) + 1;
+    memset((char *)name, 0, length);
+    heap->bytes_used -= length;
+    heap->bytes_released += length;
+    heap->name_count--;
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    size_t mask = heap->slot_count - 1;
+    size_t hole = slot;
+    for (size_t next = (slot + 1) & mask; heap->slots[next].name != NULL; next = (next + 1) & mask)
+    {
+        size_t home = hashName(heap->slots[next].name) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            heap->slots[hole] = heap->slots[next];
+            hole = next;
+        }
+    }
+    heap->slots[hole].name = NULL;
+    heap->slots[hole].refs = 0;
+}
+
+void initSlab(struct Slab *slab, size_t objectSize)
+{
+    // Every object must be able to hold the free-list link, and stay pointer aligned
+    if (objectSize < sizeof(void *))
+    {
+        objectSize = sizeof(void *);
+    }
+    slab->object_size = (objectSize + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    slab->chunks = NULL;
+    slab->chunk_count = 0;
+    slab->chunk_used = SLAB_OBJECTS_PER_CHUNK;
+    slab->free_list = NULL;
+    slab->live = 0;
+    slab->free = 0;
+}
+
+void *slabAlloc(struct Slab *slab)
+{
+    void *object = slab->free_list;
+
+    if (object != NULL)
+    {
+        slab->free_list = *(void **)object;
+        slab->free--;
+    }
+    else
+    {
+        if (slab->chunk_used == SLAB_OBJECTS_PER_CHUNK)
+        {
+            char **chunks = realloc(slab->chunks, sizeof(char *) * (slab->chunk_count + 1));
+            if (chunks == NULL)
+            {
+                return NULL;
+            }
+            slab->chunks = chunks;
+
+            slab->chunks[slab->chunk_count] = malloc(slab->object_size * SLAB_OBJECTS_PER_CHUNK);
+            if (slab->chunks[slab->chunk_count] == NULL)
+            {
+                return NULL;
+            }
+            slab->chunk_count++;
+            slab->chunk_used = 0;
+        }
+
+        object = slab->chunks[slab->chunk_count - 1] + slab->object_size * slab->chunk_used;
+        slab->chunk_used++;
+    }
+
+    slab->live++;
+    return object;
+}
+
+void slabFree(struct Slab *slab, void *object)
+{
+    if (object == NULL)
+    {
+        return;
+    }
+
+    *(void **)object = slab->free_list;
+    slab->free_list = object;
+    slab->live--;
+    slab->free++;
+}
+
+// Returns a whole set of objects (e.g. one subtree) to the slab with a single splice
+void slabFreeBatch(struct Slab *slab, void **objects, size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i + 1 < count; ++i)
+    {
+        *(void **)objects[i] = objects[i + 1];
+    }
+    *(void **)objects[count - 1] = slab->free_list;
+    slab->free_list = objects[0];
+    slab->live -= count;
+    slab->free += count;
+}
+
+uint32_t allocInode(struct FileSystem *fs, enum InodeKind kind, const char *name, uint32_t parent, void *node)
+{
+    struct InodeTable *table = &fs->inodes;
+
+    const char *interned = internName(&fs->names, name);
+    if (interned == NULL)
+    {
+        return INODE_NONE;
+    }
+
+    uint32_t id = table->free_head;
+    if (id != INODE_NONE)
+    {
+        table->free_head = table->parents[id];
+    }
+    else
+    {
+        if (table->count == table->capacity)
+        {
+            uint32_t capacity = table->capacity > 0 ? table->capacity * 2 : 64;
+
+            unsigned char *kinds = realloc(table->kinds, sizeof(unsigned char) * capacity);
+            if (kinds != NULL)
+            {
+                table->kinds = kinds;
+            }
+            uint32_t *parents = realloc(table->parents, sizeof(uint32_t) * capacity);
+            if (parents != NULL)
+            {
+                table->parents = parents;
+            }
+            const char **names = realloc(table->names, sizeof(const char *) * capacity);
+            if (names != NULL)
+            {
+                table->names = names;
+            }
+            void **nodes = realloc(table->nodes, sizeof(void *) * capacity);
+            if (nodes != NULL)
+            {
+                table->nodes = nodes;
+            }
+
+            if (kinds == NULL || parents == NULL || names == NULL || nodes == NULL)
+            {
+                releaseName(&fs->names, interned);
+                return INODE_NONE;
+            }
+            table->capacity = capacity;
+        }
+        id = table->count++;
+    }
+
+    table->kinds[id] = (unsigned char)kind;
+    table->parents[id] = parent;
+    table->names[id] = interned;
+    table->nodes[id] = node;
+
+    if (kind == INODE_FILE)
+    {
+        table->file_count++;
+    }
+    else
+    {
+        table->dir_count++;
+    }
+    return id;
+}
+
+void freeInode(struct FileSystem *fs, uint32_t id)
+{
+    struct InodeTable *table = &fs->inodes;
+
+    if (table->kinds[id] == INODE_FILE)
+    {
+        table->file_count--;
+    }
+    else if (table->kinds[id] == INODE_DIR)
+    {
+        table->dir_count--;
+    }
+
+    releaseName(&fs->names, table->names[id]);
+    table->kinds[id] = INODE_FREE;
+    table->names[id] = NULL;
+    table->nodes[id] = NULL;
+    table->parents[id] = table->free_head;
+    table->free_head = id;
+}
+
+const char *nodeName(const struct FileSystem *fs, uint32_t id)
+{
+    return fs->inodes.names[id];
+}
+
+// Returns the slot holding 'name', or the empty slot where it would go
+static size_t nameIndexSlot(const struct NameIndex *index, const char *name)
+{
+    size_t mask = index->slot_count - 1;
+    size_t slot = hashName(name) & mask;
+    while (index->slots[slot].name != NULL && strcmp(index->slots[slot].name, name) != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int nameIndexGrow(struct NameIndex *index)
+{
+    size_t slotCount = index->slot_count > 0 ? index->slot_count * 2 : 1024;
+    struct NamePosting *slots = calloc(slotCount, sizeof(struct NamePosting));
+    if (slots == NULL)
+    {
+        return -1;
+    }
+
+    struct NameIndex grown = {slots, slotCount, index->name_count};
+    for (size_t i = 0; i < index->slot_count; ++i)
+    {
+        if (index->slots[i].name != NULL)
+        {
+            slots[nameIndexSlot(&grown, index->slots[i].name)] = index->slots[i];
+        }
+    }
+
+    free(index->slots);
+    *index = grown;
+    return 0;
+}
+
+// Records a file under its name; the file's name_pos remembers where, so removal is O(1)
+int nameIndexAdd(struct FileSystem *fs, uint32_t fileId)
+{
+    struct NameIndex *index = &fs->name_index;
+
+    // Keep the index at most half full
+    if ((index->name_count + 1) * 2 > index->slot_count && nameIndexGrow(index) != 0)
+    {
+        return -1;
+    }
+
+    const char *name = fs->inodes.names[fileId];
+    struct NamePosting *posting = &index->slots[nameIndexSlot(index, name)];
+    if (posting->count == posting->capacity)
+    {
+        uint32_t capacity = posting->capacity > 0 ? posting->capacity * 2 : 4;
+        uint32_t *ids = realloc(posting->ids, sizeof(uint32_t) * capacity);
+        if (ids == NULL)
+        {
+            return -1;
+        }
+        posting->ids = ids;
+        posting->capacity = capacity;
+    }
+    if (posting->name == NULL)
+    {
+        posting->name = name;
+        index->name_count++;
+    }
+
+    struct File *file = fs->inodes.nodes[fileId];
+    file->name_pos = posting->count;
+    posting->ids[posting->count++] = fileId;
+    return 0;
+}
+
+// Drops a file from its name's posting list by moving the last entry into its place. A
+// name no file carries any more leaves the index, so it does not pin its interned copy.
+void nameIndexRemove(struct FileSystem *fs, uint32_t fileId)
+{
+    struct NameIndex *index = &fs->name_index;
+    if (index->slot_count == 0)
+    {
+        return;
+    }
+
+    size_t slot = nameIndexSlot(index, fs->inodes.names[fileId]);
+    struct NamePosting *posting = &index->slots[slot];
+    struct File *file = fs->inodes.nodes[fileId];
+    if (posting->name == NULL || file->name_pos >= posting->count || posting->ids[file->name_pos] != fileId)
+    {
+        return;
+    }
+
+    uint32_t lastId = posting->ids[--posting->count];
+    if (lastId != fileId)
+    {
+        posting->ids[file->name_pos] = lastId;
+        ((struct File *)fs->inodes.nodes[lastId])->name_pos = file->name_pos;
+    }
+    file->name_pos = INODE_NONE;
+    if (posting->count > 0)
+    {
+        return;
+    }
+
+    free(posting->ids);
+    index->name_count--;
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    size_t mask = index->slot_count - 1;
+    size_t hole = slot;
+    for (size_t next = (slot + 1) & mask; index->slots[next].name != NULL; next = (next + 1) & mask)
+    {
+        size_t home = hashName(index->slots[next].name) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            index->slots[hole] = index->slots[next];
+            hole = next;
+        }
+    }
+    memset(&index->slots[hole], 0, sizeof(struct NamePosting));
+}
+
+const struct NamePosting *nameIndexLookup(const struct NameIndex *index, const char *name)
+{
+    if (index->slot_count == 0)
+    {
+        return NULL;
+    }
+
+    const struct NamePosting *posting = &index->slots[nameIndexSlot(index, name)];
+    return posting->name != NULL && posting->count > 0 ? posting : NULL;
+}
+
+// Repacks the live names into fresh blocks once released names take more room than they
+// do, and repoints the inode table and name index at the new copies. Nothing may hold a
+// name across it, so it runs only once a delete is done with the nodes it freed.
+void compactNames(struct FileSystem *fs)
+{
+    struct StringHeap *heap = &fs->names;
+    if (heap->bytes_released < STRING_HEAP_BLOCK_SIZE || heap->bytes_released <= heap->bytes_used)
+    {
+        return;
+    }
+
+    struct StringHeap packed;
+    memset(&packed, 0, sizeof(struct StringHeap));
+    const char **copies = malloc(sizeof(const char *) * heap->slot_count);
+    int failed = copies == NULL;
+    for (size_t i = 0; i < heap->slot_count && !failed; ++i)
+    {
+        const char *name = heap->slots[i].name;
+        copies[i] = name != NULL ? stringHeapStore(&packed, name, strlen(name) + 1) : NULL;
+        failed = name != NULL && copies[i] == NULL;
+    }
+    if (failed)
+    {
+        // The old blocks stay in use; compaction is retried after the next delete
+        for (int b = 0; b < packed.block_count; ++b)
+        {
+            free(packed.blocks[b]);
+        }
+        free(packed.blocks);
+        free(copies);
+        return;
+    }
+
+    // Old names stay readable until every reference has been repointed
+    struct InodeTable *table = &fs->inodes;
+    for (uint32_t id = 0; id < table->count; ++id)
+    {
+        if (table->names[id] != NULL)
+        {
+            table->names[id] = copies[stringHeapSlot(heap, table->names[id])];
+        }
+    }
+    for (size_t i = 0; i < fs->name_index.slot_count; ++i)
+    {
+        struct NamePosting *posting = &fs->name_index.slots[i];
+        if (posting->name != NULL)
+        {
+            posting->name = table->names[posting->ids[0]];
+        }
+    }
+    for (size_t i = 0; i < heap->slot_count; ++i)
+    {
+        heap->slots[i].name = copies[i];
+    }
+    free(copies);
+
+    for (int b = 0; b < heap->block_count; ++b)
+    {
+        free(heap->blocks[b]);
+    }
+    free(heap->blocks);
+    heap->blocks = packed.blocks;
+    heap->block_count = packed.block_count;
+    heap->block_used = packed.block_used;
+    heap->bytes_released = 0;
+}
+
+// True when 'id' is 'ancestorId' or lies somewhere below it
+int isInSubtree(const struct FileSystem *fs, uint32_t id, uint32_t ancestorId)
+{
+    for (uint32_t current = id; current != INODE_NONE; current = fs->inodes.parents[current])
+    {
+        if (current == ancestorId)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Paths are not stored on nodes; they are rebuilt from the parent ids when needed.
+// Writes the path of directory 'id' ("~" for the root) and returns its length; like
+// snprintf, nothing is written when it does not fit, so callers can size a buffer first.
+size_t buildDirectoryPath(const struct FileSystem *fs, uint32_t id, char *buffer, size_t size)
+{
+    const struct InodeTable *table = &fs->inodes;
+    uint32_t rootId = fs->root->id;
+
+    if (id == rootId)
+    {
+        if (size >= 2)
+        {
+            strcpy(buffer, "~");
+        }
+        return 1;
+    }
+
+    size_t length = 0;
+    for (uint32_t current = id; current != rootId && current != INODE_NONE; current = table->parents[current])
+    {
+        length += strlen(table->names[current]) + (length > 0 ? 1 : 0);
+    }
+
+    if (length >= size)
+    {
+        return length;
+    }
+
+    size_t position = length;
+    buffer[position] = '\0';
+    for (uint32_t current = id; current != rootId && current != INODE_NONE; current = table->parents[current])
+    {
+        size_t nameLength = strlen(table->names[current]);
+        position -= nameLength;
+        memcpy(buffer + position, table->names[current], nameLength);
+        if (position > 0)
+        {
+            buffer[--position] = '/';
+        }
+    }
+    return length;
+}
+
+struct File *findFile(struct FileSystem *fs, struct Directory *dir, const char *name)
+{
+    uint32_t id = childIndexFind(&fs->inodes, &dir->files, name);
+    return id == INODE_NONE ? NULL : fs->inodes.nodes[id];
+}
+
+struct Directory *findSubdirectory(struct FileSystem *fs, struct Directory *dir, const char *name)
+{
+    uint32_t id = childIndexFind(&fs->inodes, &dir->subdirectories, name);
+    return id == INODE_NONE ? NULL : fs->inodes.nodes[id];
+}
+
+// Creates an empty file node under parentDir; NULL if memory runs out, with nothing left behind
+struct File *newFileNode(struct FileSystem *fs, struct Directory *parentDir, const char *name)
+{
+    struct File *file = slabAlloc(&fs->file_slab);
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    initFile(file);
+
+    file->id = allocInode(fs, INODE_FILE, name, parentDir->id, file);
+    if (file->id == INODE_NONE)
+    {
+        slabFree(&fs->file_slab, file);
+        return NULL;
+    }
+
+    if (childIndexInsert(&fs->inodes, &parentDir->files, file->id) != 0)
+    {
+        freeInode(fs, file->id);
+        slabFree(&fs->file_slab, file);
+        return NULL;
+    }
+
+    if (nameIndexAdd(fs, file->id) != 0)
+    {
+        childIndexRemove(&fs->inodes, &parentDir->files, name);
+        freeInode(fs, file->id);
+        slabFree(&fs->file_slab, file);
+        return NULL;
+    }
+    return file;
+}
+
+// Creates an empty directory node under parentDir; NULL if memory runs out, with nothing left behind
+struct Directory *newDirectoryNode(struct FileSystem *fs, struct Directory *parentDir, const char *name)
+{
+    struct Directory *dir = slabAlloc(&fs->dir_slab);
+    if (dir == NULL)
+    {
+        return NULL;
+    }
+
+    initDirectory(dir);
+
+    dir->id = allocInode(fs, INODE_DIR, name, parentDir->id, dir);
+    if (dir->id == INODE_NONE)
+    {
+        slabFree(&fs->dir_slab, dir);
+        return NULL;
+    }
+
+    if (childIndexInsert(&fs->inodes, &parentDir->subdirectories, dir->id) != 0)
+    {
+        freeInode(fs, dir->id);
+        slabFree(&fs->dir_slab, dir);
+        return NULL;
+    }
+    return dir;
+}
+
+// Fills the gear table the chunker rolls over content; any fixed pseudo-random table works
+static void initBlockStore(struct BlockStore *store)
+{
+    memset(store, 0, sizeof(struct BlockStore));
+    initPlatformLock(&store->lock);
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 256; ++i)
+    {
+        // splitmix64
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        store->gear[i] = z ^ (z >> 31);
+    }
+}
+
+static uint64_t hashBlockBytes(const unsigned char *data, size_t length)
+{
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ length;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, length - i);
+    hash = (hash ^ tail) * 0xC4CEB9FE1A85EC53ull;
+    return hash ^ (hash >> 29);
+}
+
+// Length of the next content-defined chunk: the first point past CHUNK_MIN_SIZE where the
+// rolling gear hash has its top CHUNK_AVERAGE_BITS bits clear, capped at CHUNK_MAX_SIZE.
+// Cut points depend only on nearby bytes, so an insertion only changes the chunks around it.
+static size_t nextChunkLength(const struct BlockStore *store, const unsigned char *data, uint64_t length)
+{
+    if (length <= CHUNK_MIN_SIZE)
+    {
+        return (size_t)length;
+    }
+
+    size_t limit = length < CHUNK_MAX_SIZE ? (size_t)length : CHUNK_MAX_SIZE;
+    const uint64_t mask = ((UINT64_C(1) << CHUNK_AVERAGE_BITS) - 1) << (64 - CHUNK_AVERAGE_BITS);
+    uint64_t fingerprint = 0;
+    for (size_t i = CHUNK_MIN_SIZE; i < limit; ++i)
+    {
+        fingerprint = (fingerprint << 1) + store->gear[data[i]];
+        if ((fingerprint & mask) == 0)
+        {
+            return i + 1;
+        }
+    }
+    return limit;
+}
+
+// Appends one LZ sequence: a token with the literal and match lengths, the literals, then a
+// 2-byte back offset and the match. A final sequence has literals only. Returns the new
+// output length, or 0 if the sequence does not fit.
+static size_t lzEmitSequence(unsigned char *out, size_t capacity, size_t used, const unsigned char *literals,
+                             size_t literalLength, size_t offset, size_t matchLength)
+{
+    if (used + 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1 > capacity)
+    {
+        return 0;
+    }
+
+    unsigned char *token = &out[used++];
+    size_t rest = literalLength;
+    *token = (unsigned char)((rest >= 15 ? 15 : rest) << 4);
+    if (rest >= 15)
+    {
+        for (rest -= 15; rest >= 255; rest -= 255)
+        {
+            out[used++] = 255;
+        }
+        out[used++] = (unsigned char)rest;
+    }
+    memcpy(out + used, literals, literalLength);
+    used += literalLength;
+
+    if (matchLength > 0)
+    {
+        out[used++] = (unsigned char)(offset & 0xFF);
+        out[used++] = (unsigned char)(offset >> 8);
+        rest = matchLength - 4;
+        *token |= (unsigned char)(rest >= 15 ? 15 : rest);
+        if (rest >= 15)
+        {
+            for (rest -= 15; rest >= 255; rest -= 255)
+            {
+                out[used++] = 255;
+            }
+            out[used++] = (unsigned char)rest;
+        }
+    }
+    return used;
+}
+
+// Greedy LZ77 over a hash of 4-byte sequences, in the style of LZ4. Returns the compressed
+// length, or 0 when the output would not be shorter than 'capacity'.
+static size_t lzCompress(const unsigned char *in, size_t length, unsigned char *out, size_t capacity)
+{
+    uint32_t table[1 << LZ_HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    size_t anchor = 0;
+    size_t used = 0;
+    size_t i = 0;
+    while (i + 4 <= length)
+    {
+        uint32_t sequence;
+        memcpy(&sequence, in + i, sizeof(sequence));
+        uint32_t slot = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+        size_t candidate = table[slot];
+        table[slot] = (uint32_t)i;
+
+        if (candidate < i && i - candidate <= 65535 && memcmp(in + candidate, in + i, 4) == 0)
+        {
+            size_t matchLength = 4;
+            while (i + matchLength < length && in[candidate + matchLength] == in[i + matchLength])
+            {
+                matchLength++;
+            }
+            used = lzEmitSequence(out, capacity, used, in + anchor, i - anchor, i - candidate, matchLength);
+            if (used == 0)
+            {
+                return 0;
+            }
+            i += matchLength;
+            anchor = i;
+        }
+        else
+        {
+            // Step faster through data that keeps missing, so incompressible blocks stay cheap
+            i += 1 + ((i - anchor) >> 6);
+        }
+    }
+
+    used = lzEmitSequence(out, capacity, used, in + anchor, length - anchor, 0, 0);
+    return used < capacity ? used : 0;
+}
+
+static size_t lzReadLength(const unsigned char *in, size_t length, size_t *position, size_t value)
+{
+    if (value == 15)
+    {
+        unsigned char byte;
+        do
+        {
+            if (*position >= length)
+            {
+                return SIZE_MAX;
+            }
+            byte = in[(*position)++];
+            value += byte;
+        } while (byte == 255);
+    }
+    return value;
+}
+
+// Expands exactly 'capacity' bytes; returns -1 if the input is malformed
+static int lzDecompress(const unsigned char *in, size_t length, unsigned char *out, size_t capacity)
+{
+    size_t position = 0;
+    size_t used = 0;
+    while (position < length)
+    {
+        unsigned char token = in[position++];
+        size_t literalLength = lzReadLength(in, length, &position, token >> 4);
+        if (literalLength > length - position || literalLength > capacity - used)
+        {
+            return -1;
+        }
+        memcpy(out + used, in + position, literalLength);
+        position += literalLength;
+        used += literalLength;
+
+        if (position == length)
+        {
+            break;
+        }
+        if (length - position < 2)
+        {
+            return -1;
+        }
+        size_t offset = in[position] | (size_t)in[position + 1] << 8;
+        position += 2;
+        size_t matchLength = lzReadLength(in, length, &position, token & 15);
+        if (matchLength == SIZE_MAX || offset == 0 || offset > used || matchLength + 4 > capacity - used)
+        {
+            return -1;
+        }
+        matchLength += 4;
+
+        // The match may overlap the bytes it is producing, which repeats them
+        const unsigned char *from = out + used - offset;
+        if (offset >= matchLength)
+        {
+            memcpy(out + used, from, matchLength);
+        }
+        else
+        {
+            for (size_t k = 0; k < matchLength; ++k)
+            {
+                out[used + k] = from[k];
+            }
+        }
+        used += matchLength;
+    }
+    return used == capacity ? 0 : -1;
+}
+
+// Compresses a block's bytes into a fresh buffer; NULL when they do not shrink
+static char *packBlockBytes(const char *data, uint32_t length, uint32_t *storedLength)
+{
+    unsigned char *packed = malloc(length);
+    size_t packedLength = packed != NULL ? lzCompress((const unsigned char *)data, length, packed, length) : 0;
+    if (packedLength == 0)
+    {
+        free(packed);
+        return NULL;
+    }
+
+    char *shrunk = realloc(packed, packedLength);
+    *storedLength = (uint32_t)packedLength;
+    return shrunk != NULL ? shrunk : (char *)packed;
+}
+
+static void countPackedBlock(struct BlockStore *store, uint32_t length, uint32_t storedLength, double milliseconds)
+{
+    store->compress_milliseconds += milliseconds;
+    if (storedLength < length)
+    {
+        store->compressed_blocks++;
+        store->compressed_input_bytes += length;
+        store->compressed_bytes += storedLength;
+    }
+}
+
+// Expands a compressed block into 'out', which holds at least block->length bytes
+static int unpackBlockBytes(struct BlockStore *store, const struct Block *block, char *out)
+{
+    double start = getMilliseconds();
+    int result = lzDecompress((const unsigned char *)block->data, block->stored_length, (unsigned char *)out, block->length);
+    atomicAdd64(&store->decompressed_bytes, block->length);
+    atomicAdd64(&store->decompress_nanoseconds, (int64_t)((getMilliseconds() - start) * 1e6));
+    return result;
+}
+
+static void forgetPackedBlock(struct BlockStore *store, const struct Block *block)
+{
+    if (block->stored_length < block->length)
+    {
+        store->compressed_blocks--;
+        store->compressed_input_bytes -= block->length;
+        store->compressed_bytes -= block->stored_length;
+    }
+}
+
+// Stores a block's bytes compressed or plain from now on. Blocks that do not shrink stay plain.
+// Frees the old bytes, so no other thread may be reading the block.
+static int convertBlock(struct BlockStore *store, struct Block *block, int compress)
+{
+    if (compress == (block->stored_length < block->length))
+    {
+        return 0;
+    }
+
+    uint32_t storedLength = block->length;
+    char *data;
+    if (compress)
+    {
+        double start = getMilliseconds();
+        data = packBlockBytes(block->data, block->length, &storedLength);
+        countPackedBlock(store, block->length, storedLength, getMilliseconds() - start);
+        if (data == NULL)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        data = malloc(block->length);
+        if (data == NULL || unpackBlockBytes(store, block, data) != 0)
+        {
+            free(data);
+            return -1;
+        }
+        forgetPackedBlock(store, block);
+    }
+
+    store->stored_bytes = store->stored_bytes - block->stored_length + storedLength;
+    free(block->data);
+    block->data = data;
+    block->stored_length = storedLength;
+    return 0;
+}
+
+// Confirms a hash match byte for byte, expanding a compressed block to compare it
+static int blockHoldsBytes(struct BlockStore *store, const struct Block *block, const unsigned char *data)
+{
+    if (block->stored_length == block->length)
+    {
+        return memcmp(block->data, data, block->length) == 0;
+    }
+
+    char *expanded = malloc(block->length);
+    int equal = expanded != NULL && unpackBlockBytes(store, block, expanded) == 0 && memcmp(expanded, data, block->length) == 0;
+    free(expanded);
+    return equal;
+}
+
+static int blockStoreGrow(struct BlockStore *store)
+{
+    size_t slotCount = store->slot_count > 0 ? store->slot_count * 2 : 1024;
+    struct Block **slots = calloc(slotCount, sizeof(struct Block *));
+    if (slots == NULL)
+    {
+        return -1;
+    }
+
+    for (size_t i = 0; i < store->slot_count; ++i)
+    {
+        struct Block *block = store->slots[i];
+        while (block != NULL)
+        {
+            struct Block *next = block->next;
+            size_t slot = (size_t)block->hash & (slotCount - 1);
+            block->next = slots[slot];
+            slots[slot] = block;
+            block = next;
+        }
+    }
+
+    free(store->slots);
+    store->slots = slots;
+    store->slot_count = slotCount;
+    return 0;
+}
+
+static struct Block *blockStoreFind(struct BlockStore *store, uint64_t hash, const unsigned char *data, uint32_t length)
+{
+    if (store->slot_count > 0)
+    {
+        for (struct Block *block = store->slots[(size_t)hash & (store->slot_count - 1)]; block != NULL; block = block->next)
+        {
+            if (block->hash == hash && block->length == length && blockHoldsBytes(store, block, data))
+            {
+                return block;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Returns a reference to the block holding these bytes, storing them if no block does yet.
+// With 'compress' a new block is stored compressed. A block already stored plain is shared
+// as it is: other files may be reading its bytes without the lock, so only a compression
+// command, which runs alone, converts it. Callable from several threads at once: new bytes
+// are copied or compressed outside the store lock, adding the time spent compressing to
+// '*packMilliseconds'.
+static struct Block *blockStoreAcquire(struct BlockStore *store, const unsigned char *data, uint32_t length, int compress,
+                                       double *packMilliseconds)
+{
+    uint64_t hash = hashBlockBytes(data, length);
+    uint32_t storedLength = length;
+    double packTime = 0;
+    char *bytes = NULL;
+
+    for (;;)
+    {
+        acquirePlatformLock(&store->lock);
+        store->chunks += bytes == NULL;
+
+        struct Block *block = blockStoreFind(store, hash, data, length);
+        if (block != NULL)
+        {
+            block->refs++;
+            store->referenced_bytes += length;
+            store->duplicates++;
+            releasePlatformLock(&store->lock);
+            free(bytes);
+            return block;
+        }
+        if (bytes != NULL)
+        {
+            break;
+        }
+        releasePlatformLock(&store->lock);
+
+        // Not stored yet; look again once the bytes are ready, in case another thread stored them meanwhile
+        if (compress)
+        {
+            double start = getMilliseconds();
+            bytes = packBlockBytes((const char *)data, length, &storedLength);
+            packTime = getMilliseconds() - start;
+            *packMilliseconds += packTime;
+        }
+        if (bytes == NULL && (bytes = malloc(length)) != NULL)
+        {
+            memcpy(bytes, data, length);
+        }
+        if (bytes == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    struct Block *block = malloc(sizeof(struct Block));
+    if (block == NULL || (store->block_count >= store->slot_count && blockStoreGrow(store) != 0))
+    {
+        releasePlatformLock(&store->lock);
+        free(block);
+        free(bytes);
+        return NULL;
+    }
+    block->hash = hash;
+    block->refs = 1;
+    block->length = length;
+    block->stored_length = storedLength;
+    block->data = bytes;
+
+    size_t slot = (size_t)hash & (store->slot_count - 1);
+    block->next = store->slots[slot];
+    store->slots[slot] = block;
+    store->block_count++;
+    store->stored_bytes += storedLength;
+    store->referenced_bytes += length;
+    if (compress)
+    {
+        countPackedBlock(store, length, storedLength, packTime);
+    }
+    releasePlatformLock(&store->lock);
+    return block;
+}
+
+// Drops one reference and frees the block with the last one; returns the stored bytes freed
+static uint64_t blockStoreRelease(struct BlockStore *store, struct Block *block)
+{
+    acquirePlatformLock(&store->lock);
+    store->referenced_bytes -= block->length;
+    if (--block->refs > 0)
+    {
+        releasePlatformLock(&store->lock);
+        return 0;
+    }
+
+    struct Block **link = &store->slots[(size_t)block->hash & (store->slot_count - 1)];
+    while (*link != block)
+    {
+        link = &(*link)->next;
+    }
+    *link = block->next;
+
+    uint64_t bytes = block->stored_length;
+    forgetPackedBlock(store, block);
+    store->block_count--;
+    store->stored_bytes -= bytes;
+    releasePlatformLock(&store->lock);
+
+    free(block->data);
+    free(block);
+    return bytes;
+}
+
+// Chunks content into the block store. Any thread may call this; NULL if memory runs out.
+static struct Content *chunkContent(struct BlockStore *store, const unsigned char *bytes, uint64_t length, int compress)
+{
+    struct Content *content = malloc(sizeof(struct Content));
+    if (content == NULL)
+    {
+        return NULL;
+    }
+    content->refs = 1;
+    content->mapped = 0;
+    content->writable = 0;
+    content->dirty = NULL;
+    content->dirty_count = 0;
+    content->dirty_capacity = 0;
+    content->state = CONTENT_READY;
+    content->mapping.data = NULL;
+    content->mapping.size = 0;
+    content->host_path = NULL;
+    content->data = NULL;
+    content->capacity = 0;
+    content->store = store;
+    content->blocks = NULL;
+    content->block_count = 0;
+
+    double start = getMilliseconds();
+    double packMilliseconds = 0;
+    uint32_t capacity = 0;
+    uint64_t offset = 0;
+    while (offset < length)
+    {
+        if (content->block_count == capacity)
+        {
+            uint32_t grown = capacity > 0 ? capacity * 2 : 4;
+            struct BlockRef *blocks = grown > capacity ? realloc(content->blocks, sizeof(struct BlockRef) * grown) : NULL;
+            if (blocks == NULL)
+            {
+                break;
+            }
+            content->blocks = blocks;
+            capacity = grown;
+        }
+
+        size_t chunk = nextChunkLength(store, bytes + offset, length - offset);
+        struct Block *block = blockStoreAcquire(store, bytes + offset, (uint32_t)chunk, compress, &packMilliseconds);
+        if (block == NULL)
+        {
+            break;
+        }
+        content->blocks[content->block_count].block = block;
+        content->blocks[content->block_count].offset = offset;
+        content->block_count++;
+        offset += chunk;
+    }
+
+    acquirePlatformLock(&store->lock);
+    store->chunk_milliseconds += getMilliseconds() - start - packMilliseconds;
+    releasePlatformLock(&store->lock);
+
+    if (offset < length)
+    {
+        for (uint32_t i = 0; i < content->block_count; ++i)
+        {
+            blockStoreRelease(store, content->blocks[i].block);
+        }
+        free(content->blocks);
+        free(content);
+        return NULL;
+    }
+    return content;
+}
+
+// Content served straight from a host file mapping, which it takes over
+static struct Content *mappedContent(const struct HostMapping *mapping, const char *hostPath)
+{
+    struct Content *content = malloc(sizeof(struct Content));
+    if (content == NULL)
+    {
+        return NULL;
+    }
+    content->refs = 1;
+    content->mapped = 1;
+    content->writable = mapping->writable;
+    content->dirty = NULL;
+    content->dirty_count = 0;
+    content->dirty_capacity = 0;
+    content->state = CONTENT_READY;
+    content->mapping = *mapping;
+    content->host_path = strdup(hostPath);
+    content->data = (char *)mapping->data;
+    content->capacity = 0;
+    content->store = NULL;
+    content->blocks = NULL;
+    content->block_count = 0;
+    return content;
+}
+
+// Maps the host file of lazily loaded content when it is first read. Whichever thread gets
+// there first maps it while the others wait; the host file must still have the size and
+// modification time recorded when it was loaded. -1 if it is gone or has changed since.
+static int mapDeferredContent(struct Content *content)
+{
+    long state = atomicRead(&content->state);
+    if (state == CONTENT_DEFERRED)
+    {
+        // A thread that loses the race sees the state the winner left and waits below
+        state = atomicCompareExchange(&content->state, CONTENT_DEFERRED, CONTENT_MAPPING);
+    }
+    if (state == CONTENT_DEFERRED)
+    {
+        struct MapOptions map = {ACCESS_NORMAL, 0, 0, content->mapping.writable};
+        struct HostMapping mapping;
+        int mapped = mapHostFile(content->host_path, &map, &mapping) == 0;
+        if (mapped && (mapping.size != content->mapping.size || mapping.modified != content->mapping.modified))
+        {
+            unmapHostFile(&mapping);
+            mapped = 0;
+        }
+        if (mapped)
+        {
+            content->mapping = mapping;
+            content->data = (char *)mapping.data;
+        }
+        else
+        {
+            printf("Host file '%s' changed or disappeared since it was loaded; load it again to read it.\n", content->host_path);
+        }
+        state = mapped ? CONTENT_READY : CONTENT_UNAVAILABLE;
+        atomicCompareExchange(&content->state, CONTENT_MAPPING, state);
+        return mapped ? 0 : -1;
+    }
+
+    while (state == CONTENT_MAPPING)
+    {
+        yieldPlatformThread();
+        state = atomicRead(&content->state);
+    }
+    if (state == CONTENT_UNAVAILABLE)
+    {
+        printf("Host file '%s' changed or disappeared since it was loaded; load it again to read it.\n", content->host_path);
+        return -1;
+    }
+    return 0;
+}
+
+// Whether the file's bytes can be read; lazy content whose host file changed cannot. Callers
+// check it before they print a header or truncate a host file for the bytes.
+static int isContentReadable(const struct File *file)
+{
+    return file->small != NULL || file->content == NULL || mapDeferredContent(file->content) == 0;
+}
+
+void initFileSystem(struct FileSystem *fs)
+{
+    if (fs != NULL)
+    {
+        memset(&fs->inodes, 0, sizeof(struct InodeTable));
+        fs->inodes.free_head = INODE_NONE;
+        memset(&fs->names, 0, sizeof(struct StringHeap));
+        memset(&fs->name_index, 0, sizeof(struct NameIndex));
+        memset(&fs->trigrams, 0, sizeof(struct TrigramIndex));
+        initBlockStore(&fs->blocks);
+        initSlab(&fs->file_slab, sizeof(struct File));
+        initSlab(&fs->dir_slab, sizeof(struct Directory));
+        for (int i = 0; i < SMALL_CLASS_COUNT; ++i)
+        {
+            initSlab(&fs->small_slabs[i], (size_t)SMALL_CLASS_MIN << i);
+        }
+
+        fs->root = slabAlloc(&fs->dir_slab);
+        if (fs->root == NULL)
+        {
+            printf("Memory allocation failed for the root directory.\n");
+            return;
+        }
+
+        initDirectory(fs->root);
+
+        fs->root->id = allocInode(fs, INODE_DIR, "root", INODE_NONE, fs->root);
+        if (fs->root->id == INODE_NONE)
+        {
+            printf("Memory allocation failed for the root directory.\n");
+            slabFree(&fs->dir_slab, fs->root);
+            return;
+        }
+
+        struct Directory *home = slabAlloc(&fs->dir_slab);
+        if (home == NULL)
+        {
+            printf("Memory allocation failed for the 'home' directory.\n");
+            slabFree(&fs->dir_slab, fs->root);
+            return;
+        }
+
+        initDirectory(home);
+
+        home->id = allocInode(fs, INODE_DIR, "home", fs->root->id, home);
+        if (home->id == INODE_NONE || childIndexInsert(&fs->inodes, &fs->root->subdirectories, home->id) != 0)
+        {
+            printf("Memory allocation failed for the 'home' directory.\n");
+            slabFree(&fs->dir_slab, home);
+            slabFree(&fs->dir_slab, fs->root);
+            return;
+        }
+        fs->current_directory = home;
+
+        fs->dcache.entries = calloc(DENTRY_CACHE_SIZE, sizeof(struct DentryCacheEntry));
+        fs->dcache.generation = 1;
+        fs->dcache.hits = 0;
+        fs->dcache.misses = 0;
+        fs->dcache.invalidations = 0;
+
+        memset(&fs->host_io, 0, sizeof(struct HostIoSettings));
+        fs->host_io.backend = HOST_IO_URING;
+        fs->host_io.queue_depth = HOST_IO_DEFAULT_DEPTH;
+        fs->host_io.inflight_bytes = (uint64_t)HOST_IO_DEFAULT_INFLIGHT_MB << 20;
+
+        fs->user_count = 0;
+        fs->current_user.access_level = LOW;
+        strcpy(fs->current_user.username, "guest");
+
+        for (int i = 0; i < MAX_USERS; ++i)
+        {
+            initUser(&(fs->users[i]));
+        }
+
+        strcpy(fs->users[fs->user_count].username, "admin");
+        strcpy(fs->users[fs->user_count].password, "YAwC4@mdesdin-1r2#3");
+        fs->users[fs->user_count].access_level = HIGHEST;
+        fs->user_count++;
+    }
+}
+
+int createFileInDir(struct FileSystem *fs, const char *path, const char *name)
+{
+    if (name == NULL || isWhitespaceString(name))
+    {
+        printf("Invalid file name provided.\n");
+        return -1;
+    }
+
+    if (strlen(name) >= MAX_FILE_NAME_LENGTH)
+    {
+        printf("File name length exceeds maximum limit.\n");
+        return -2;
+    }
+
+    if (path == NULL)
+    {
+        printf("Invalid path provided for file creation.\n");
+        return -3;
+    }
+
+    if (strlen(path) >= MAX_PATH_LENGTH)
+    {
+        printf("Path length exceeds maximum limit.\n");
+        return -4;
+    }
+
+    char *inputPath = path;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        // Stay in the current directory
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *parentDir = goTo(fs, inputPath);
+    if (parentDir != NULL)
+    {
+        // Check if the file already exists in the parent directory
+        if (findFile(fs, parentDir, name) != NULL)
+        {
+            printf("File '%s' already exists in path: %s\n", name, path);
+            return -6;
+        }
+
+        // Create a new file
+        struct File *newFile = newFileNode(fs, parentDir, name);
+        if (newFile == NULL)
+        {
+            printf("Memory allocation failed for file creation.\n");
+            return -7;
+        }
+
+        char parentPath[MAX_PATH_LENGTH];
+        buildDirectoryPath(fs, parentDir->id, parentPath, sizeof(parentPath));
+        printf("File '%s' created at path: %s\n", name, parentPath);
+
+        return 0; // Success
+    }
+    else
+    {
+        printf("Parent directory not found at path: %s\n", path);
+        return -8;
+    }
+}
+
+void createDirectory(struct FileSystem *fs, const char *path, const char *name)
+{
+    if (name == NULL || isWhitespaceString(name))
+    {
+        printf("Invalid directory name provided.\n");
+        return;
+    }
+
+    if (strlen(name) >= MAX_FILE_NAME_LENGTH)
+    {
+        printf("Directory name length exceeds maximum limit.\n");
+        return;
+    }
+
+    if (path == NULL)
+    {
+        printf("Invalid path provided for directory creation.\n");
+        return;
+    }
+
+    if (strlen(path) >= MAX_PATH_LENGTH)
+    {
+        printf("Path length exceeds maximum limit.\n");
+        return;
+    }
+
+    char *inputPath = path;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        // Stay in the current directory
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *parentDir = goTo(fs, inputPath);
+    if (parentDir != NULL)
+    {
+        // Check if the directory already exists in the parent directory
+        if (findSubdirectory(fs, parentDir, name) != NULL)
+        {
+            printf("Directory '%s' already exists in path: %s\n", name, path);
+            return;
+        }
+
+        // Create a new directory
+        struct Directory *newDir = newDirectoryNode(fs, parentDir, name);
+        if (newDir == NULL)
+        {
+            printf("Memory allocation failed for directory creation.\n");
+            return;
+        }
+
+        char newPath[MAX_PATH_LENGTH];
+        buildDirectoryPath(fs, newDir->id, newPath, sizeof(newPath));
+        printf("Directory '%s' created at path: %s\n", name, newPath);
+    }
+    else
+    {
+        printf("Parent directory not found at path: %s\n", path);
+    }
+}
+
+void writeFile(struct FileSystem *fs, const char *filePath, const char *fileName, const char *content)
+{
+    if (fs == NULL || filePath == NULL || fileName == NULL || content == NULL ||
+        isWhitespaceString(filePath) || isWhitespaceString(fileName))
+    {
+        printf("Invalid parameters provided for file writing.\n");
+        return;
+    }
+
+    size_t pathLength = strlen(filePath);
+    size_t fileNameLength = strlen(fileName);
+
+    // Check for maximum path and file name lengths
+    if (pathLength >= MAX_PATH_LENGTH || fileNameLength >= MAX_FILE_NAME_LENGTH)
+    {
+        printf("Path or file name length exceeds maximum limit.\n");
+        return;
+    }
+
+    char *inputPath = filePath;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        // Stay in the current directory
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *dir = goTo(fs, inputPath);
+
+    if (dir != NULL)
+    {
+        struct File *existingFile = findFile(fs, dir, fileName);
+
+        if (existingFile != NULL)
+        {
+            if (replaceFileContent(fs, existingFile, content, strlen(content)) != 0)
+            {
+                printf("Memory allocation failed while writing file '%s'.\n", fileName);
+                return;
+            }
+            updateTrigramIndex(fs, existingFile);
+            printf("Content written to file '%s'.\n", fileName);
+        }
+        else
+        {
+            // If the file doesn't exist, create it
+            createFileInDir(fs, filePath, fileName);
+
+            struct File *newFile = findFile(fs, dir, fileName);
+            if (newFile != NULL)
+            {
+                if (setFileContent(fs, newFile, content, strlen(content)) != 0)
+                {
+                    printf("Memory allocation failed while writing file '%s'.\n", fileName);
+                    return;
+                }
+                updateTrigramIndex(fs, newFile);
+                printf("File '%s' created and content written.\n", fileName);
+            }
+        }
+    }
+    else
+    {
+        printf("Directory not found at path: %s\n", filePath);
+    }
+}
+
+// Content whose writes go straight to its host file: a writable mapping held by one file
+static int isWritableMapping(const struct Content *content)
+{
+    return content != NULL && content->refs == 1 && content->writable;
+}
+
+// Records [start, end) of a writable mapping as written, widened to whole pages and merged
+// with any range it touches; -1 if memory runs out, before anything is recorded
+static int markDirtyRange(struct Content *content, uint64_t start, uint64_t end)
+{
+    start -= start % DIRTY_PAGE_SIZE;
+    end += (DIRTY_PAGE_SIZE - end % DIRTY_PAGE_SIZE) % DIRTY_PAGE_SIZE;
+
+    // First range that ends at or after the start; every one up to the first that begins
+    // after the end merges into the new range
+    uint32_t first = 0;
+    uint32_t high = content->dirty_count;
+    while (first < high)
+    {
+        uint32_t middle = first + (high - first) / 2;
+        if (content->dirty[middle].end < start)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    uint32_t last = first;
+    while (last < content->dirty_count && content->dirty[last].start <= end)
+    {
+        start = content->dirty[last].start < start ? content->dirty[last].start : start;
+        end = content->dirty[last].end > end ? content->dirty[last].end : end;
+        last++;
+    }
+
+    if (last == first)
+    {
+        if (content->dirty_count == content->dirty_capacity)
+        {
+            uint32_t capacity = content->dirty_capacity > 0 ? content->dirty_capacity * 2 : 4;
+            struct DirtyRange *dirty = realloc(content->dirty, sizeof(struct DirtyRange) * capacity);
+            if (dirty == NULL)
+            {
+                return -1;
+            }
+            content->dirty = dirty;
+            content->dirty_capacity = capacity;
+        }
+        memmove(&content->dirty[first + 1], &content->dirty[first], sizeof(struct DirtyRange) * (content->dirty_count - first));
+        content->dirty_count++;
+        last = first + 1;
+    }
+    content->dirty[first].start = start;
+    content->dirty[first].end = end;
+    memmove(&content->dirty[first + 1], &content->dirty[last], sizeof(struct DirtyRange) * (content->dirty_count - last));
+    content->dirty_count -= last - first - 1;
+    return 0;
+}
+
+// Gets a file served from a writable mapping ready for 'length' bytes at 'offset': marks the
+// pages written and resizes the host file to 'size'. Its bytes are then written in place.
+static int prepareMappedWrite(struct File *file, uint64_t offset, uint64_t length, uint64_t size)
+{
+    struct Content *content = file->content;
+    uint64_t start = offset < file->size ? offset : file->size; // A gap past the end is written too
+    if (offset + length > start && markDirtyRange(content, start, offset + length) != 0)
+    {
+        return -1;
+    }
+    if (resizeHostMapping(content->host_path, &content->mapping, size) != 0)
+    {
+        return -1;
+    }
+    content->data = (char *)content->mapping.data;
+    return 0;
+}
+
+// Appends to a file; the buffer grows geometrically and only the new bytes are copied
+int appendFile(struct FileSystem *fs, struct File *file, const void *data, uint64_t length)
+{
+    return writeFileAt(fs, file, file->size, data, length);
+}
+
+// Writes 'length' bytes at 'offset' like pwrite: the file grows if needed and a gap past
+// the old end reads as zeros. Bytes outside [offset, offset + length) are left untouched.
+int writeFileAt(struct FileSystem *fs, struct File *file, uint64_t offset, const void *data, uint64_t length)
+{
+    uint64_t oldSize = file->size;
+    uint64_t end = offset + length;
+
+    // Content still to be mapped is mapped first, so the bytes around the write are there
+    if (end < offset || (file->small == NULL && file->content != NULL && mapDeferredContent(file->content) != 0))
+    {
+        return -1;
+    }
+
+    // A writable mapping takes the bytes in place, so they land in its host file
+    if (isWritableMapping(file->content))
+    {
+        if (prepareMappedWrite(file, offset, length, end > oldSize ? end : oldSize) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (reserveFileContent(fs, file, end > oldSize ? end : oldSize) != 0)
+    {
+        return -1;
+    }
+
+    char *content = file->small != NULL ? file->small : file->content->data;
+    if (offset > oldSize)
+    {
+        memset(content + oldSize, 0, (size_t)(offset - oldSize));
+    }
+    if (length > 0)
+    {
+        memcpy(content + offset, data, (size_t)length);
+    }
+    if (end > oldSize)
+    {
+        file->size = end;
+        if (file->small != NULL || !file->content->mapped)
+        {
+            content[end] = '\0'; // A mapped view has no room for a terminator
+        }
+    }
+
+    // Writes past the old end only add trigrams; anything else replaces some
+    if (file->trigram_epoch != 0 && offset >= oldSize && isContentIndexed(fs, fs->inodes.parents[file->id]))
+    {
+        trigramIndexAppend(fs, file, oldSize);
+    }
+    else
+    {
+        updateTrigramIndex(fs, file);
+    }
+    return 0;
+}
+
+void appendToFileAtPath(struct FileSystem *fs, const char *filePath, const char *fileName, const char *content)
+{
+    if (fs == NULL || filePath == NULL || fileName == NULL || content == NULL)
+    {
+        printf("Invalid parameters provided for file writing.\n");
+        return;
+    }
+
+    struct File *file = getFileInDirectory(fs, filePath, fileName);
+    if (file == NULL)
+    {
+        return;
+    }
+
+    size_t length = strlen(content);
+    if (appendFile(fs, file, content, length) != 0)
+    {
+        printf("Memory allocation failed while writing file '%s'.\n", fileName);
+        return;
+    }
+    printf("Appended %zu bytes to file '%s' (size now %llu bytes).\n", length, fileName, (unsigned long long)file->size);
+}
+
+void writeToFileAtPath(struct FileSystem *fs, const char *filePath, const char *fileName, uint64_t offset, const char *content)
+{
+    if (fs == NULL || filePath == NULL || fileName == NULL || content == NULL)
+    {
+        printf("Invalid parameters provided for file writing.\n");
+        return;
+    }
+
+    struct File *file = getFileInDirectory(fs, filePath, fileName);
+    if (file == NULL)
+    {
+        return;
+    }
+
+    size_t length = strlen(content);
+    if (writeFileAt(fs, file, offset, content, length) != 0)
+    {
+        printf("Memory allocation failed while writing file '%s'.\n", fileName);
+        return;
+    }
+    printf("Wrote %zu bytes at offset %llu in file '%s' (size now %llu bytes).\n",
+           length, (unsigned long long)offset, fileName, (unsigned long long)file->size);
+}
+
+void initContentView(struct ContentView *view)
+{
+    view->data = "";
+    view->length = 0;
+    view->scratch = NULL;
+    view->scratch_block = NULL;
+}
+
+// Borrows up to 'length' bytes from 'offset' without copying; the range is clamped to the
+// content. Chunked content is not contiguous, so the view also ends at the end of the block
+// holding 'offset' and callers wanting more continue from there; it is empty only at the end
+// of the file. A compressed block is expanded into the view's scratch buffer, once for any
+// number of views within it. The view stays valid until the file is next written, loaded or
+// deleted, or the view is reused.
+int viewFileContent(const struct File *file, uint64_t offset, uint64_t length, struct ContentView *view)
+{
+    const struct Content *content = file->content;
+    view->data = "";
+    view->length = 0;
+
+    if (offset > file->size)
+    {
+        return -1;
+    }
+    if ((content == NULL && file->small == NULL) || offset == file->size)
+    {
+        return 0;
+    }
+
+    uint64_t available = file->size - offset;
+    if (file->small != NULL)
+    {
+        view->data = file->small + offset;
+    }
+    else if (content->store == NULL)
+    {
+        if (mapDeferredContent(file->content) != 0)
+        {
+            return -1;
+        }
+        view->data = content->data + offset;
+    }
+    else
+    {
+        // Last block starting at or before the offset
+        uint32_t low = 0;
+        uint32_t high = content->block_count - 1;
+        while (low < high)
+        {
+            uint32_t middle = low + (high - low + 1) / 2;
+            if (content->blocks[middle].offset <= offset)
+            {
+                low = middle;
+            }
+            else
+            {
+                high = middle - 1;
+            }
+        }
+        const struct BlockRef *ref = &content->blocks[low];
+        const struct Block *block = ref->block;
+        const char *bytes = block->data;
+        if (block->stored_length < block->length)
+        {
+            if (view->scratch_block != block)
+            {
+                view->scratch_block = NULL;
+                if (view->scratch == NULL && (view->scratch = malloc(CHUNK_MAX_SIZE)) == NULL)
+                {
+                    return -1;
+                }
+                if (unpackBlockBytes(content->store, block, view->scratch) != 0)
+                {
+                    return -1;
+                }
+                view->scratch_block = block;
+            }
+            bytes = view->scratch;
+        }
+        view->data = bytes + (offset - ref->offset);
+        available = block->length - (offset - ref->offset);
+    }
+    view->length = length < available ? length : available;
+    return 0;
+}
+
+void freeContentView(struct ContentView *view)
+{
+    free(view->scratch);
+    initContentView(view);
+}
+
+// Copies up to 'length' bytes from 'offset' into 'buffer' and returns how many were copied
+uint64_t readFileAt(const struct File *file, uint64_t offset, void *buffer, uint64_t length)
+{
+    struct ContentView view;
+    uint64_t copied = 0;
+    initContentView(&view);
+    while (copied < length && viewFileContent(file, offset + copied, length - copied, &view) == 0 && view.length > 0)
+    {
+        memcpy((char *)buffer + copied, view.data, (size_t)view.length);
+        copied += view.length;
+    }
+    freeContentView(&view);
+    return copied;
+}
+
+// Writes up to 'length' bytes from 'offset' to a stream, one view at a time
+static uint64_t printFileContent(const struct File *file, uint64_t offset, uint64_t length, FILE *stream)
+{
+    struct ContentView view;
+    uint64_t written = 0;
+    initContentView(&view);
+    while (written < length && viewFileContent(file, offset + written, length - written, &view) == 0 && view.length > 0)
+    {
+        fwrite(view.data, 1, (size_t)view.length, stream);
+        written += view.length;
+    }
+    freeContentView(&view);
+    return written;
+}
+
+// The whole content as one run of bytes: borrowed when it is already contiguous, otherwise
+// gathered into a buffer handed back through 'owned' for the caller to free. NULL if that fails.
+static const char *contiguousFileContent(const struct File *file, char **owned)
+{
+    struct ContentView view;
+    initContentView(&view);
+    int result = viewFileContent(file, 0, file->size, &view);
+    if (result == 0 && view.length == file->size)
+    {
+        // A lone compressed block was expanded into the view's buffer, which the caller now owns
+        *owned = view.scratch;
+        return view.data;
+    }
+    freeContentView(&view);
+
+    // Content that cannot be read, such as a lazy file whose host file changed, gives NULL
+    *owned = result == 0 ? malloc((size_t)file->size) : NULL;
+    if (*owned != NULL && readFileAt(file, 0, *owned, file->size) < file->size)
+    {
+        free(*owned);
+        *owned = NULL;
+    }
+    return *owned;
+}
+
+void readFileRange(struct FileSystem *fs, const char *filePath, const char *fileName, uint64_t offset, uint64_t length)
+{
+    if (fs == NULL || filePath == NULL || fileName == NULL || isWhitespaceString(filePath) || isWhitespaceString(fileName))
+    {
+        printf("Invalid parameters provided for file reading.\n");
+        return;
+    }
+
+    const char *inputPath = filePath;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct File *file = getFileInDirectory(fs, inputPath, fileName);
+    if (file == NULL)
+    {
+        return;
+    }
+
+    if (offset > file->size)
+    {
+        printf("Offset %llu is past the end of file '%s' (%llu bytes).\n",
+               (unsigned long long)offset, fileName, (unsigned long long)file->size);
+        return;
+    }
+    if (length > file->size - offset)
+    {
+        length = file->size - offset;
+    }
+    if (!isContentReadable(file))
+    {
+        return;
+    }
+
+    printf("Content of file '%s', bytes %llu-%llu of %llu:\n", fileName, (unsigned long long)offset,
+           (unsigned long long)(offset + length), (unsigned long long)file->size);
+    printFileContent(file, offset, length, stdout);
+    printf("\n");
+}
+
+void readFile(struct FileSystem *fs, const char *filePath, const char *fileName)
+{
+    if (fs == NULL || filePath == NULL || fileName == NULL || isWhitespaceString(filePath) || isWhitespaceString(fileName))
+    {
+        printf("Invalid parameters provided for file reading.\n");
+        return;
+    }
+
+    size_t pathLength = strlen(filePath);
+    size_t fileNameLength = strlen(fileName);
+
+    // Check for maximum path and file name lengths
+    if (pathLength >= MAX_PATH_LENGTH || fileNameLength >= MAX_FILE_NAME_LENGTH)
+    {
+        printf("Path or file name length exceeds maximum limit.\n");
+        return;
+    }
+
+    char *inputPath = filePath;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        // Stay in the current directory
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *dir = goTo(fs, inputPath);
+
+    if (dir != NULL)
+    {
+        if (dir->files.count <= 0)
+        {
+            printf("No files found in directory '%s'.\n", filePath);
+            return;
+        }
+
+        struct File *file = findFile(fs, dir, fileName);
+        if (file != NULL)
+        {
+            // Content is binary-safe and a mapped view has no terminator, so write exactly size bytes
+            if (!isContentReadable(file))
+            {
+                return;
+            }
+            printf("Content of file '%s':\n", fileName);
+            printFileContent(file, 0, file->size, stdout);
+            printf("\n");
+            return;
+        }
+
+        printf("File '%s' not found in directory '%s'.\n", fileName, filePath);
+    }
+    else
+    {
+        printf("Directory not found at path: %s\n", filePath);
+    }
+}
+
+void deleteFileAtPath(struct FileSystem *fs, const char *path, const char *fileName)
+{
+    if (fs == NULL || path == NULL || fileName == NULL || isWhitespaceString(path) || isWhitespaceString(fileName))
+    {
+        printf("Invalid parameters provided for file deletion.\n");
+        return;
+    }
+
+    size_t pathLength = strlen(path);
+    size_t fileNameLength = strlen(fileName);
+
+    // Check for maximum path and file name lengths
+    if (pathLength >= MAX_PATH_LENGTH || fileNameLength >= MAX_FILE_NAME_LENGTH)
+    {
+        printf("Path or file name length exceeds maximum limit.\n");
+        return;
+    }
+
+    char *inputPath = path;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        // Stay in the current directory
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *dir = goTo(fs, inputPath);
+
+    if (dir != NULL)
+    {
+        uint32_t fileId = childIndexRemove(&fs->inodes, &dir->files, fileName);
+
+        if (fileId != INODE_NONE)
+        {
+            struct File *file = fs->inodes.nodes[fileId];
+
+            releaseFileContent(fs, file);
+            trigramForgetFile(fs, file);
+            nameIndexRemove(fs, fileId);
+            freeInode(fs, fileId);
+            slabFree(&fs->file_slab, file);
+
+            printf("File '%s' deleted from directory '%s'.\n", fileName, nodeName(fs, dir->id));
+            compactNames(fs);
+        }
+        else
+        {
+            printf("File '%s' not found in directory '%s'.\n", fileName, path);
+        }
+    }
+    else
+    {
+        printf("Directory not found at path: %s\n", path);
+    }
+}
+
+// Size class for small content taking 'needed' bytes with its terminator: -1 for the file
+// node's inline bytes, SMALL_CLASS_COUNT when it is too big for any packed slab
+static int smallContentClass(uint64_t needed)
+{
+    if (needed <= FILE_INLINE_SIZE)
+    {
+        return -1;
+    }
+
+    int sizeClass = 0;
+    while (sizeClass < SMALL_CLASS_COUNT && needed > (uint64_t)SMALL_CLASS_MIN << sizeClass)
+    {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+// Storage for content of the given class; the inline bytes when it fits the node
+static char *smallContentBuffer(struct FileSystem *fs, struct File *file, int sizeClass)
+{
+    return sizeClass < 0 ? file->inline_data : slabAlloc(&fs->small_slabs[sizeClass]);
+}
+
+// Drops one reference to content of 'size' bytes; returns the bytes freed with the last one
+static uint64_t releaseContent(struct Content *content, uint64_t size)
+{
+    uint64_t bytes = 0;
+    if (--content->refs == 0)
+    {
+        bytes = size;
+        if (content->store != NULL)
+        {
+            bytes = 0;
+            for (uint32_t i = 0; i < content->block_count; ++i)
+            {
+                bytes += blockStoreRelease(content->store, content->blocks[i].block);
+            }
+            free(content->blocks);
+        }
+        else if (content->mapped)
+        {
+            // Unsynced writes to a shared mapping are left to the host's own writeback
+            unmapHostFile(&content->mapping);
+            free(content->host_path);
+            free(content->dirty);
+        }
+        else
+        {
+            free(content->data);
+        }
+        free(content);
+    }
+    return bytes;
+}
+
+// Drops the file's reference to its content, freeing or unmapping it with the last reference.
+// Returns the number of bytes actually released, which is 0 while copies or other files
+// deduplicated against the same blocks still hold them.
+uint64_t releaseFileContent(struct FileSystem *fs, struct File *file)
+{
+    uint64_t bytes = 0;
+
+    if (file->small != NULL)
+    {
+        bytes = file->size;
+        if (file->small != file->inline_data)
+        {
+            slabFree(&fs->small_slabs[smallContentClass(file->size + 1)], file->small);
+        }
+        file->small = NULL;
+    }
+
+    if (file->content != NULL)
+    {
+        bytes = releaseContent(file->content, file->size);
+    }
+
+    file->content = NULL;
+    file->size = 0;
+    return bytes;
+}
+
+// Content the file may write in place: an owned buffer, unmapped and not shared with a copy
+static int isPrivateContent(const struct Content *content)
+{
+    return content != NULL && content->refs == 1 && !content->mapped && content->store == NULL;
+}
+
+// Moves the file's bytes to the small storage sized for 'needed' bytes, which is no less than
+// the current size. The size class always follows the size, so it is known when freeing.
+static int reserveSmallContent(struct FileSystem *fs, struct File *file, uint64_t needed)
+{
+    int sizeClass = smallContentClass(needed + 1);
+    if (file->small != NULL && smallContentClass(file->size + 1) == sizeClass)
+    {
+        return 0;
+    }
+
+    char *bytes = smallContentBuffer(fs, file, sizeClass);
+    if (bytes == NULL)
+    {
+        return -1;
+    }
+
+    uint64_t size = readFileAt(file, 0, bytes, file->size);
+    if (size < file->size)
+    {
+        if (bytes != file->inline_data)
+        {
+            slabFree(&fs->small_slabs[sizeClass], bytes);
+        }
+        return -1;
+    }
+    bytes[size] = '\0';
+    releaseFileContent(fs, file);
+    file->small = bytes;
+    file->size = size;
+    return 0;
+}
+
+// Makes the content a private owned buffer with room for 'needed' bytes and a terminator,
+// keeping the current bytes; shared, chunked or mapped content is copied here, on the first write.
+// Content that stays small is kept in the file node or a packed slab object instead.
+// Capacity doubles, so a run of growing writes copies each byte O(1) times.
+int reserveFileContent(struct FileSystem *fs, struct File *file, uint64_t needed)
+{
+    struct Content *content = file->content;
+
+    if (needed >= SIZE_MAX)
+    {
+        return -1;
+    }
+    if (content == NULL && smallContentClass(needed + 1) < SMALL_CLASS_COUNT)
+    {
+        return reserveSmallContent(fs, file, needed);
+    }
+    if (isPrivateContent(content) && content->capacity > needed)
+    {
+        return 0;
+    }
+
+    uint64_t capacity = isPrivateContent(content) ? content->capacity : 64;
+    while (capacity <= needed || capacity <= file->size)
+    {
+        capacity = capacity > SIZE_MAX / 2 ? (needed > file->size ? needed : file->size) + 1 : capacity * 2;
+    }
+
+    if (isPrivateContent(content))
+    {
+        char *data = realloc(content->data, (size_t)capacity);
+        if (data == NULL)
+        {
+            return -1;
+        }
+        content->data = data;
+        content->capacity = capacity;
+        return 0;
+    }
+
+    struct Content *copy = malloc(sizeof(struct Content));
+    char *data = malloc((size_t)capacity);
+    if (copy == NULL || data == NULL)
+    {
+        free(copy);
+        free(data);
+        return -1;
+    }
+
+    uint64_t size = readFileAt(file, 0, data, file->size);
+    if (size < file->size)
+    {
+        free(copy);
+        free(data);
+        return -1;
+    }
+    data[size] = '\0';
+    releaseFileContent(fs, file);
+
+    copy->refs = 1;
+    copy->mapped = 0;
+    copy->writable = 0;
+    copy->dirty = NULL;
+    copy->dirty_count = 0;
+    copy->dirty_capacity = 0;
+    copy->state = CONTENT_READY;
+    copy->mapping.data = NULL;
+    copy->mapping.size = 0;
+    copy->host_path = NULL;
+    copy->data = data;
+    copy->capacity = capacity;
+    copy->store = NULL;
+    copy->blocks = NULL;
+    copy->block_count = 0;
+    file->content = copy;
+    file->size = size;
+    return 0;
+}
+
+// Replaces the whole content with 'length' bytes of 'data', which may hold any byte values.
+// Small content goes in the file node or a packed slab object. Anything larger is cut into
+// content-defined chunks and stored once in the block store, so files with equal runs of
+// content share them; below a compressed directory the blocks are compressed. On failure
+// the old content is kept.
+int setFileContent(struct FileSystem *fs, struct File *file, const void *data, uint64_t length)
+{
+    struct BlockStore *store = &fs->blocks;
+    const unsigned char *bytes = data;
+    int compress = isContentCompressed(fs, fs->inodes.parents[file->id]);
+    int sizeClass = smallContentClass(length + 1);
+
+    if (length == 0)
+    {
+        releaseFileContent(fs, file);
+        return 0;
+    }
+
+    if (sizeClass < SMALL_CLASS_COUNT)
+    {
+        // Rewritten in place when the size class stays; the inline bytes are never the old
+        // storage when the class changes, so they are free to take the new bytes
+        char *small = file->small;
+        if (small == NULL || smallContentClass(file->size + 1) != sizeClass)
+        {
+            small = smallContentBuffer(fs, file, sizeClass);
+            if (small == NULL)
+            {
+                return -1;
+            }
+            releaseFileContent(fs, file);
+        }
+        memcpy(small, data, (size_t)length);
+        small[length] = '\0';
+        file->small = small;
+        file->size = length;
+        return 0;
+    }
+
+    struct Content *content = chunkContent(store, bytes, length, compress);
+    if (content == NULL)
+    {
+        return -1;
+    }
+
+    releaseFileContent(fs, file);
+    file->content = content;
+    file->size = length;
+    return 0;
+}
+
+// Replaces the whole content like setFileContent, except that a file served from a writable
+// mapping keeps it: its host file is resized and rewritten in place
+int replaceFileContent(struct FileSystem *fs, struct File *file, const void *data, uint64_t length)
+{
+    if (!isWritableMapping(file->content))
+    {
+        return setFileContent(fs, file, data, length);
+    }
+    if (mapDeferredContent(file->content) != 0 || prepareMappedWrite(file, 0, length, length) != 0)
+    {
+        return -1;
+    }
+    if (length > 0)
+    {
+        memcpy(file->content->data, data, (size_t)length);
+    }
+    file->size = length;
+    return 0;
+}
+
+// Makes 'target' a copy of 'source' that shares its bytes until either one is written.
+// Small content is copied outright, which costs no more than sharing it.
+int shareFileContent(struct FileSystem *fs, struct File *target, const struct File *source)
+{
+    releaseFileContent(fs, target);
+    if (source->small != NULL)
+    {
+        if (reserveSmallContent(fs, target, source->size) != 0)
+        {
+            return -1;
+        }
+        memcpy(target->small, source->small, (size_t)source->size + 1);
+        target->size = source->size;
+        return 0;
+    }
+
+    // A copy of a file written through to its host file gets bytes of its own
+    if (source->content != NULL && source->content->writable)
+    {
+        char *owned = NULL;
+        const char *bytes = source->size > 0 ? contiguousFileContent(source, &owned) : "";
+        int result = bytes != NULL ? setFileContent(fs, target, bytes, source->size) : -1;
+        free(owned);
+        return result;
+    }
+
+    if (source->content != NULL)
+    {
+        source->content->refs++;
+    }
+    target->content = source->content;
+    target->size = source->size;
+    return 0;
+}
+
+// Adds a node to a batch bound for slabFreeBatch, or frees it on the spot if the batch cannot grow
+static void queueSlabFree(struct Slab *slab, void ***batch, size_t *count, size_t *capacity, void *object)
+{
+    if (*count == *capacity)
+    {
+        size_t newCapacity = *capacity > 0 ? *capacity * 2 : 256;
+        void **grown = realloc(*batch, sizeof(void *) * newCapacity);
+        if (grown == NULL)
+        {
+            slabFree(slab, object);
+            return;
+        }
+        *batch = grown;
+        *capacity = newCapacity;
+    }
+    (*batch)[(*count)++] = object;
+}
+
+// Frees a directory and everything below it in one pass. The directory must already be
+// unlinked from its parent. Children are popped straight off each directory's id array
+// and the walk climbs back up through the parent ids, so no path is ever resolved.
+void teardownDirectory(struct FileSystem *fs, struct Directory *dir, struct TeardownStats *stats)
+{
+    struct InodeTable *table = &fs->inodes;
+    double start = getMilliseconds();
+
+    memset(stats, 0, sizeof(struct TeardownStats));
+
+    void **fileBatch = NULL;
+    size_t fileCount = 0;
+    size_t fileCapacity = 0;
+    void **dirBatch = NULL;
+    size_t dirCount = 0;
+    size_t dirCapacity = 0;
+
+    uint32_t topId = dir->id;
+    uint32_t currentId = topId;
+
+    while (1)
+    {
+        struct Directory *current = table->nodes[currentId];
+
+        // Descend until a directory has no subdirectories left
+        if (current->subdirectories.count > 0)
+        {
+            currentId = current->subdirectories.ids[--current->subdirectories.count];
+            continue;
+        }
+
+        for (int i = 0; i < current->files.count; ++i)
+        {
+            uint32_t fileId = current->files.ids[i];
+            struct File *file = table->nodes[fileId];
+
+            stats->content_bytes += releaseFileContent(fs, file);
+            stats->node_bytes += fs->file_slab.object_size;
+            stats->files++;
+            trigramForgetFile(fs, file);
+            nameIndexRemove(fs, fileId);
+            freeInode(fs, fileId);
+            queueSlabFree(&fs->file_slab, &fileBatch, &fileCount, &fileCapacity, file);
+        }
+
+        stats->node_bytes += fs->dir_slab.object_size;
+        stats->node_bytes += (size_t)(current->files.capacity + current->subdirectories.capacity) * sizeof(uint32_t);
+        stats->node_bytes += (size_t)(current->files.slot_count + current->subdirectories.slot_count) * sizeof(int);
+        stats->directories++;
+
+        uint32_t parentId = table->parents[currentId];
+        freeChildIndex(&current->files);
+        freeChildIndex(&current->subdirectories);
+        freeInode(fs, currentId);
+        queueSlabFree(&fs->dir_slab, &dirBatch, &dirCount, &dirCapacity, current);
+
+        if (currentId == topId)
+        {
+            break;
+        }
+        currentId = parentId;
+    }
+
+    slabFreeBatch(&fs->file_slab, fileBatch, fileCount);
+    slabFreeBatch(&fs->dir_slab, dirBatch, dirCount);
+    free(fileBatch);
+    free(dirBatch);
+
+    stats->milliseconds = getMilliseconds() - start;
+}
+
+void deleteDirectoryAtPath(struct FileSystem *fs, const char *path)
+{
+    if (fs == NULL || path == NULL || isWhitespaceString(path))
+    {
+        printf("Invalid parameters provided. Cannot delete directory.\n");
+        return;
+    }
+
+    // Check for potential buffer overflow in the path
+    if (strlen(path) >= MAX_PATH_LENGTH)
+    {
+        printf("Path length exceeds maximum limit.\n");
+        return;
+    }
+
+    const char *inputPath = path;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        // Stay in the current directory
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *dirToDelete = goTo(fs, inputPath);
+
+    if (dirToDelete != NULL)
+    {
+        uint32_t dirId = dirToDelete->id;
+        uint32_t parentId = fs->inodes.parents[dirId];
+
+        if (parentId == INODE_NONE)
+        {
+            printf("The root directory cannot be deleted.\n");
+            return;
+        }
+
+        struct Directory *parentDir = fs->inodes.nodes[parentId];
+
+        // Step out of the subtree if the current directory is inside it
+        for (uint32_t id = fs->current_directory->id; id != INODE_NONE; id = fs->inodes.parents[id])
+        {
+            if (id == dirId)
+            {
+                fs->current_directory = parentDir;
+                break;
+            }
+        }
+
+        char dirPath[MAX_PATH_LENGTH];
+        buildDirectoryPath(fs, dirId, dirPath, sizeof(dirPath));
+
+        childIndexRemove(&fs->inodes, &parentDir->subdirectories, nodeName(fs, dirId));
+        invalidateDentryCache(fs);
+
+        struct TeardownStats stats;
+        teardownDirectory(fs, dirToDelete, &stats);
+
+        printf("Directory '%s' deleted: %zu directories and %zu files, %llu content bytes and %zu node bytes reclaimed in %.3f ms.\n",
+               dirPath, stats.directories, stats.files, (unsigned long long)stats.content_bytes, stats.node_bytes, stats.milliseconds);
+        compactNames(fs);
+    }
+    else
+    {
+        printf("Directory not found at path: %s\n", path);
+    }
+}
+
+static int walkWorkerCount(void)
+{
+    int count = processorCount();
+    return count > WALK_MAX_WORKERS ? WALK_MAX_WORKERS : count;
+}
+
+static int walkPush(struct WalkWorker *worker, uint32_t id)
+{
+    acquirePlatformLock(&worker->lock);
+    if (worker->tail == worker->capacity)
+    {
+        if (worker->head > 0)
+        {
+            // Reuse the slots thieves have already emptied before growing
+            memmove(worker->deque, worker->deque + worker->head, sizeof(uint32_t) * (worker->tail - worker->head));
+            worker->tail -= worker->head;
+            worker->head = 0;
+        }
+        else
+        {
+            size_t capacity = worker->capacity > 0 ? worker->capacity * 2 : 64;
+            uint32_t *deque = realloc(worker->deque, sizeof(uint32_t) * capacity);
+            if (deque == NULL)
+            {
+                releasePlatformLock(&worker->lock);
+                return -1;
+            }
+            worker->deque = deque;
+            worker->capacity = capacity;
+        }
+    }
+    worker->deque[worker->tail++] = id;
+    releasePlatformLock(&worker->lock);
+    return 0;
+}
+
+// The owner takes its newest directory, keeping its own walk depth-first
+static int walkPop(struct WalkWorker *worker, uint32_t *id)
+{
+    int found = 0;
+    acquirePlatformLock(&worker->lock);
+    if (worker->tail > worker->head)
+    {
+        *id = worker->deque[--worker->tail];
+        found = 1;
+    }
+    releasePlatformLock(&worker->lock);
+    return found;
+}
+
+// Thieves take the oldest directory of another worker, which tends to be the largest subtree
+static int walkSteal(struct WalkWorker *worker, uint32_t *id)
+{
+    struct WalkWorker *workers = worker - worker->index;
+    int count = worker->walk->worker_count;
+
+    for (int i = 1; i < count; ++i)
+    {
+        struct WalkWorker *victim = &workers[(worker->index + i) % count];
+        int found = 0;
+
+        acquirePlatformLock(&victim->lock);
+        if (victim->tail > victim->head)
+        {
+            *id = victim->deque[victim->head++];
+            found = 1;
+        }
+        releasePlatformLock(&victim->lock);
+
+        if (found)
+        {
+            worker->steals++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void walkVisit(struct WalkWorker *worker, uint32_t id)
+{
+    struct TreeWalk *walk = worker->walk;
+    const struct InodeTable *table = &walk->fs->inodes;
+    struct Directory *dir = table->nodes[id];
+
+    worker->directories++;
+    if (walk->visitDirectory == NULL || walk->visitDirectory(worker, dir) == 0)
+    {
+        worker->files += dir->files.count;
+        if (walk->visitFile != NULL)
+        {
+            for (int i = 0; i < dir->files.count; ++i)
+            {
+                walk->visitFile(worker, table->nodes[dir->files.ids[i]]);
+            }
+        }
+
+        for (int i = 0; i < dir->subdirectories.count; ++i)
+        {
+            atomicIncrement(&walk->pending);
+            if (walkPush(worker, dir->subdirectories.ids[i]) != 0)
+            {
+                walk->failed = 1;
+                atomicDecrement(&walk->pending);
+            }
+        }
+    }
+
+    atomicDecrement(&walk->pending);
+}
+
+static void walkWorkerMain(void *param)
+{
+    struct WalkWorker *worker = param;
+    uint32_t id;
+
+    while (1)
+    {
+        if (walkPop(worker, &id) || walkSteal(worker, &id))
+        {
+            walkVisit(worker, id);
+        }
+        else if (atomicRead(&worker->walk->pending) == 0)
+        {
+            break;
+        }
+        else
+        {
+            yieldPlatformThread();
+        }
+    }
+}
+
+int walkEmit(struct WalkWorker *worker, uint32_t id, uint64_t value, const char *text)
+{
+    if (worker->record_count == worker->record_capacity)
+    {
+        size_t capacity = worker->record_capacity > 0 ? worker->record_capacity * 2 : 64;
+        struct WalkRecord *records = realloc(worker->records, sizeof(struct WalkRecord) * capacity);
+        if (records == NULL)
+        {
+            worker->walk->failed = 1;
+            return -1;
+        }
+        worker->records = records;
+        worker->record_capacity = capacity;
+    }
+
+    struct WalkRecord *record = &worker->records[worker->record_count];
+    record->id = id;
+    record->value = value;
+    record->text = text != NULL ? strdup(text) : NULL;
+    record->path = NULL;
+    worker->record_count++;
+    return 0;
+}
+
+static int compareWalkRecords(const void *a, const void *b)
+{
+    const struct WalkRecord *left = a;
+    const struct WalkRecord *right = b;
+
+    int order = strcmp(left->path, right->path);
+    if (order != 0)
+    {
+        return order;
+    }
+    if (left->value != right->value)
+    {
+        return left->value < right->value ? -1 : 1;
+    }
+    return strcmp(left->text != NULL ? left->text : "", right->text != NULL ? right->text : "");
+}
+
+// Gives a record the path of its node: the directory path, or the directory path plus the file name
+static char *walkRecordPath(const struct FileSystem *fs, uint32_t id)
+{
+    const struct InodeTable *table = &fs->inodes;
+    uint32_t dirId = table->kinds[id] == INODE_FILE ? table->parents[id] : id;
+    size_t length = buildDirectoryPath(fs, dirId, NULL, 0);
+    size_t nameLength = table->kinds[id] == INODE_FILE ? strlen(table->names[id]) + 1 : 0;
+
+    char *path = malloc(length + nameLength + 1);
+    if (path != NULL)
+    {
+        buildDirectoryPath(fs, dirId, path, length + 1);
+        if (nameLength > 0)
+        {
+            path[length] = '/';
+            strcpy(path + length + 1, table->names[id]);
+        }
+    }
+    return path;
+}
+
+// Walks the subtree on every core. Worker 0 is the calling thread; records from all workers
+// are merged and sorted by node path only after every worker has finished.
+int runTreeWalk(struct TreeWalk *walk)
+{
+    double start = getMilliseconds();
+    struct Directory *root = walk->fs->inodes.nodes[walk->root];
+
+    int workerCount = walk->worker_count > 0 ? walk->worker_count : walkWorkerCount();
+    if (workerCount > WALK_MAX_WORKERS)
+    {
+        workerCount = WALK_MAX_WORKERS;
+    }
+    if (root->subdirectories.count == 0)
+    {
+        workerCount = 1;
+    }
+
+    struct WalkWorker *workers = calloc(workerCount, sizeof(struct WalkWorker));
+    if (workers == NULL)
+    {
+        return -1;
+    }
+
+    walk->worker_count = workerCount;
+    walk->pending = 1;
+    walk->failed = 0;
+    for (int i = 0; i < workerCount; ++i)
+    {
+        workers[i].walk = walk;
+        workers[i].index = i;
+        initPlatformLock(&workers[i].lock);
+    }
+
+    if (walkPush(&workers[0], walk->root) != 0)
+    {
+        walk->failed = 1;
+        walk->pending = 0;
+    }
+
+    PlatformThread threads[WALK_MAX_WORKERS];
+    int threadCount = 0;
+    for (int i = 1; i < workerCount; ++i)
+    {
+        if (startPlatformThread(&threads[threadCount], walkWorkerMain, &workers[i]) == 0)
+        {
+            threadCount++;
+        }
+    }
+
+    walkWorkerMain(&workers[0]);
+
+    for (int i = 0; i < threadCount; ++i)
+    {
+        joinPlatformThread(threads[i]);
+    }
+
+    size_t recordCount = 0;
+    walk->total = 0;
+    walk->directories = 0;
+    walk->files = 0;
+    walk->steals = 0;
+    for (int i = 0; i < workerCount; ++i)
+    {
+        walk->total += workers[i].total;
+        walk->directories += workers[i].directories;
+        walk->files += workers[i].files;
+        walk->steals += workers[i].steals;
+        recordCount += workers[i].record_count;
+    }
+
+    walk->records = recordCount > 0 ? malloc(sizeof(struct WalkRecord) * recordCount) : NULL;
+    walk->record_count = 0;
+    for (int i = 0; i < workerCount; ++i)
+    {
+        if (walk->records != NULL)
+        {
+            memcpy(walk->records + walk->record_count, workers[i].records, sizeof(struct WalkRecord) * workers[i].record_count);
+            walk->record_count += workers[i].record_count;
+        }
+        else
+        {
+            for (size_t j = 0; j < workers[i].record_count; ++j)
+            {
+                free(workers[i].records[j].text);
+            }
+        }
+        free(workers[i].records);
+        free(workers[i].deque);
+        deletePlatformLock(&workers[i].lock);
+    }
+    free(workers);
+
+    if (recordCount > 0 && walk->records == NULL)
+    {
+        walk->failed = 1;
+    }
+
+    for (size_t i = 0; i < walk->record_count; ++i)
+    {
+        walk->records[i].path = walkRecordPath(walk->fs, walk->records[i].id);
+        if (walk->records[i].path == NULL)
+        {
+            walk->records[i].path = strdup("");
+            walk->failed = 1;
+        }
+    }
+    qsort(walk->records, walk->record_count, sizeof(struct WalkRecord), compareWalkRecords);
+
+    walk->milliseconds = getMilliseconds() - start;
+    return walk->failed ? -1 : 0;
+}
+
+void freeTreeWalk(struct TreeWalk *walk)
+{
+    for (size_t i = 0; i < walk->record_count; ++i)
+    {
+        free(walk->records[i].text);
+        free(walk->records[i].path);
+    }
+    free(walk->records);
+    walk->records = NULL;
+    walk->record_count = 0;
+}
+
+// Records each directory's own content bytes; the rollup happens after the walk
+static int diskUsageVisitDirectory(struct WalkWorker *worker, struct Directory *dir)
+{
+    const struct InodeTable *table = &worker->walk->fs->inodes;
+    uint64_t bytes = 0;
+
+    for (int i = 0; i < dir->files.count; ++i)
+    {
+        bytes += ((struct File *)table->nodes[dir->files.ids[i]])->size;
+    }
+
+    worker->total += bytes;
+    walkEmit(worker, dir->id, bytes, NULL);
+    return 0;
+}
+
+void diskUsageAtPath(struct FileSystem *fs, const char *path)
+{
+    if (fs == NULL || path == NULL || isWhitespaceString(path))
+    {
+        printf("Invalid parameters provided for disk usage.\n");
+        return;
+    }
+
+    if (strlen(path) >= MAX_PATH_LENGTH)
+    {
+        printf("Path length exceeds maximum limit.\n");
+        return;
+    }
+
+    const char *inputPath = path;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *dir = goTo(fs, inputPath);
+    if (dir == NULL)
+    {
+        printf("Directory not found at path: %s\n", path);
+        return;
+    }
+
+    struct TreeWalk walk = {0};
+    walk.fs = fs;
+    walk.root = dir->id;
+    walk.visitDirectory = diskUsageVisitDirectory;
+
+    if (runTreeWalk(&walk) != 0)
+    {
+        printf("Memory allocation failed during disk usage walk.\n");
+        freeTreeWalk(&walk);
+        return;
+    }
+
+    uint64_t *sizes = calloc(fs->inodes.count, sizeof(uint64_t));
+    if (sizes == NULL)
+    {
+        printf("Memory allocation failed during disk usage walk.\n");
+        freeTreeWalk(&walk);
+        return;
+    }
+
+    // Records are in path order, so every directory comes after its parent; fold sizes upwards in reverse
+    for (size_t i = walk.record_count; i-- > 0;)
+    {
+        uint32_t id = walk.records[i].id;
+        sizes[id] += walk.records[i].value;
+        if (id != dir->id)
+        {
+            sizes[fs->inodes.parents[id]] += sizes[id];
+        }
+    }
+
+    for (size_t i = 0; i < walk.record_count; ++i)
+    {
+        uint32_t id = walk.records[i].id;
+        if (id != dir->id && fs->inodes.parents[id] == dir->id)
+        {
+            printf("%-12llu %s\n", (unsigned long long)sizes[id], walk.records[i].path);
+        }
+    }
+
+    char dirPath[MAX_PATH_LENGTH];
+    buildDirectoryPath(fs, dir->id, dirPath, sizeof(dirPath));
+    printf("%-12llu %s\n", (unsigned long long)sizes[dir->id], dirPath);
+    printf("%zu directories and %zu files walked by %d workers in %.3f ms (%zu steals).\n",
+           walk.directories, walk.files, walk.worker_count, walk.milliseconds, walk.steals);
+
+    free(sizes);
+    freeTreeWalk(&walk);
+}
+
+// Everything below the target; the target keeps its own level, as with 'chal -d'
+static int accessLevelVisitDirectory(struct WalkWorker *worker, struct Directory *dir)
+{
+    if (dir->id != worker->walk->root)
+    {
+        dir->access = *(const enum AuthorityLevel *)worker->walk->context;
+    }
+    return 0;
+}
+
+void changeAccessLevelRecursive(struct FileSystem *fs, const char *dirPath, enum AuthorityLevel newAccessLevel)
+{
+    if (fs == NULL || dirPath == NULL)
+    {
+        printf("Invalid parameter detected.\n");
+        return;
+    }
+
+    if (strlen(dirPath) >= MAX_PATH_LENGTH)
+    {
+        printf("Directory path length exceeds maximum limit.\n");
+        return;
+    }
+
+    if (newAccessLevel < LOW || newAccessLevel > HIGHEST)
+    {
+        printf("Invalid AuthorityLevel specified.\n");
+        return;
+    }
+
+    const char *inputPath = dirPath;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *targetDir = goTo(fs, inputPath);
+    if (targetDir == NULL)
+    {
+        printf("Directory not found at path: %s\n", dirPath);
+        return;
+    }
+
+    struct TreeWalk walk = {0};
+    walk.fs = fs;
+    walk.root = targetDir->id;
+    walk.visitDirectory = accessLevelVisitDirectory;
+    walk.context = &newAccessLevel;
+
+    int result = runTreeWalk(&walk);
+    freeTreeWalk(&walk);
+
+    if (result != 0)
+    {
+        printf("Memory allocation failed; some directories may keep their old access level.\n");
+        return;
+    }
+
+    printf("Access level changed for %zu directories by %d workers in %.3f ms.\n",
+           walk.directories - 1, walk.worker_count, walk.milliseconds);
+}
+
+struct GrepContext
+{
+    const char *pattern;
+    size_t pattern_length;
+    enum AuthorityLevel level;
+    volatile long skipped; // Directories above the user's access level
+    const unsigned char *candidates; // From the trigram index; NULL scans every file
+    volatile long pruned; // Indexed files the trigram index ruled out
+};
+
+// Directories the user may not access are skipped along with everything below them
+static int grepVisitDirectory(struct WalkWorker *worker, struct Directory *dir)
+{
+    struct GrepContext *context = worker->walk->context;
+    if (dir->access > context->level)
+    {
+        atomicIncrement(&context->skipped);
+        return 1;
+    }
+    return 0;
+}
+
+// Emits one record per matching line: "line:offset: text"
+static void grepVisitFile(struct WalkWorker *worker, struct File *file)
+{
+    struct GrepContext *context = worker->walk->context;
+    size_t size = (size_t)file->size;
+    size_t line = 1;
+    size_t counted = 0; // Newlines before this offset are already in 'line'
+    size_t position = 0;
+    const char *hit;
+
+    if (context->candidates != NULL && file->trigram_epoch != 0 && !context->candidates[file->id])
+    {
+        atomicIncrement(&context->pruned);
+        return;
+    }
+
+    // Matches and their lines may straddle blocks, so chunked content is searched as one run
+    char *gathered;
+    const char *content = contiguousFileContent(file, &gathered);
+    if (content == NULL)
+    {
+        return;
+    }
+
+    worker->total += size;
+
+    while (position < size && (hit = findLiteral(content + position, size - position, context->pattern, context->pattern_length)) != NULL)
+    {
+        size_t offset = (size_t)(hit - content);
+
+        for (const char *newline; counted < offset && (newline = memchr(content + counted, '\n', offset - counted)) != NULL;)
+        {
+            line++;
+            counted = (size_t)(newline - content) + 1;
+        }
+        counted = offset;
+
+        size_t lineStart = offset;
+        while (lineStart > 0 && content[lineStart - 1] != '\n')
+        {
+            lineStart--;
+        }
+        const char *newline = memchr(content + offset, '\n', size - offset);
+        size_t lineEnd = newline != NULL ? (size_t)(newline - content) : size;
+        size_t shown = lineEnd - lineStart;
+        if (shown > 0 && content[lineStart + shown - 1] == '\r')
+        {
+            shown--;
+        }
+
+        char text[256];
+        snprintf(text, sizeof(text), "%zu:%zu: %.*s", line, offset, (int)(shown > 160 ? 160 : shown), content + lineStart);
+        if (walkEmit(worker, file->id, offset, text) != 0)
+        {
+            break;
+        }
+
+        // One record per line; carry on from the next line
+        position = lineEnd + 1;
+    }
+    free(gathered);
+}
+
+void grepInPath(struct FileSystem *fs, const char *path, const char *pattern)
+{
+    if (fs == NULL || path == NULL || pattern == NULL || isWhitespaceString(path) || *pattern == '\0')
+    {
+        printf("Invalid parameters provided for content search.\n");
+        return;
+    }
+
+    if (strlen(path) >= MAX_PATH_LENGTH)
+    {
+        printf("Path length exceeds maximum limit.\n");
+        return;
+    }
+
+    const char *inputPath = path;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *dir = goTo(fs, inputPath);
+    if (dir == NULL)
+    {
+        printf("Directory not found at path: %s\n", path);
+        return;
+    }
+
+    struct GrepContext context = {pattern, strlen(pattern), fs->current_user.access_level, 0, NULL, 0};
+    unsigned char *candidates = trigramCandidates(fs, pattern, context.pattern_length);
+    context.candidates = candidates;
+
+    struct TreeWalk walk = {0};
+    walk.fs = fs;
+    walk.root = dir->id;
+    walk.visitDirectory = grepVisitDirectory;
+    walk.visitFile = grepVisitFile;
+    walk.context = &context;
+
+    int result = runTreeWalk(&walk);
+    free(candidates);
+    if (result != 0)
+    {
+        printf("Memory allocation failed during content search.\n");
+        freeTreeWalk(&walk);
+        return;
+    }
+
+    size_t matchedFiles = 0;
+    for (size_t i = 0; i < walk.record_count; ++i)
+    {
+        if (i == 0 || walk.records[i].id != walk.records[i - 1].id)
+        {
+            matchedFiles++;
+        }
+        printf("%s:%s\n", walk.records[i].path, walk.records[i].text);
+    }
+
+    double seconds = walk.milliseconds / 1000.0;
+    printf("%zu matching lines in %zu of %zu files; %llu bytes searched by %d workers in %.3f ms (%.1f MB/s).\n",
+           walk.record_count, matchedFiles, walk.files, (unsigned long long)walk.total, walk.worker_count,
+           walk.milliseconds, seconds > 0 ? walk.total / seconds / (1024.0 * 1024.0) : 0.0);
+    if (context.pruned > 0)
+    {
+        printf("%ld indexed files ruled out by the trigram index without scanning.\n", context.pruned);
+    }
+    if (context.skipped > 0)
+    {
+        printf("%ld directories skipped: access level too low.\n", context.skipped);
+    }
+
+    freeTreeWalk(&walk);
+}
+
+// True when the directory or one of its ancestors has content indexing turned on
+int isContentIndexed(const struct FileSystem *fs, uint32_t dirId)
+{
+    for (uint32_t current = dirId; current != INODE_NONE; current = fs->inodes.parents[current])
+    {
+        if (((const struct Directory *)fs->inodes.nodes[current])->content_indexed)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int isContentCompressed(const struct FileSystem *fs, uint32_t dirId)
+{
+    for (uint32_t current = dirId; current != INODE_NONE; current = fs->inodes.parents[current])
+    {
+        if (((const struct Directory *)fs->inodes.nodes[current])->compressed)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static size_t trigramSlot(const struct TrigramIndex *index, uint32_t trigram)
+{
+    size_t mask = index->slot_count - 1;
+    size_t slot = (trigram * 2654435761u) & mask;
+    while (index->slots[slot].trigram != TRIGRAM_EMPTY && index->slots[slot].trigram != trigram)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int trigramGrow(struct TrigramIndex *index)
+{
+    size_t slotCount = index->slot_count > 0 ? index->slot_count * 2 : 4096;
+    struct TrigramList *slots = malloc(sizeof(struct TrigramList) * slotCount);
+    if (slots == NULL)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < slotCount; ++i)
+    {
+        slots[i].trigram = TRIGRAM_EMPTY;
+        slots[i].count = 0;
+        slots[i].postings = NULL;
+    }
+
+    struct TrigramList *old = index->slots;
+    size_t oldCount = index->slot_count;
+    index->slots = slots;
+    index->slot_count = slotCount;
+
+    for (size_t i = 0; i < oldCount; ++i)
+    {
+        if (old[i].trigram != TRIGRAM_EMPTY)
+        {
+            slots[trigramSlot(index, old[i].trigram)] = old[i];
+        }
+    }
+    free(old);
+    return 0;
+}
+
+// Postings a list has room for: the power of two that holds its count, 0 when empty
+static uint32_t trigramCapacity(uint32_t count)
+{
+    uint32_t capacity = 1;
+    while (capacity < count)
+    {
+        capacity <<= 1;
+    }
+    return count > 0 ? capacity : 0;
+}
+
+static int trigramPostingLive(const struct FileSystem *fs, const struct TrigramPosting *posting)
+{
+    return posting->id < fs->inodes.count && fs->inodes.kinds[posting->id] == INODE_FILE &&
+           ((const struct File *)fs->inodes.nodes[posting->id])->trigram_epoch == posting->epoch;
+}
+
+// Drops stale postings once they outnumber the live ones
+static void trigramCompact(struct FileSystem *fs)
+{
+    struct TrigramIndex *index = &fs->trigrams;
+    if (index->stale_postings < 65536 || index->stale_postings <= index->live_postings)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < index->slot_count; ++i)
+    {
+        struct TrigramList *list = &index->slots[i];
+        uint32_t kept = 0;
+        for (uint32_t j = 0; j < list->count; ++j)
+        {
+            if (trigramPostingLive(fs, &list->postings[j]))
+            {
+                list->postings[kept++] = list->postings[j];
+            }
+        }
+        if (kept == 0)
+        {
+            free(list->postings);
+            list->postings = NULL;
+        }
+        else if (trigramCapacity(kept) < trigramCapacity(list->count))
+        {
+            struct TrigramPosting *postings = realloc(list->postings, sizeof(struct TrigramPosting) * trigramCapacity(kept));
+            list->postings = postings != NULL ? postings : list->postings;
+        }
+        list->count = kept;
+    }
+    index->stale_postings = 0;
+    index->compactions++;
+}
+
+// Adds the trigrams of content[from, size) to the file's postings under its current epoch.
+// 'appending' says the file may already hold postings under that epoch from an earlier scan.
+static int trigramScan(struct FileSystem *fs, struct File *file, size_t from, int appending)
+{
+    struct TrigramIndex *index = &fs->trigrams;
+    size_t size = (size_t)file->size;
+    struct ContentView view;
+    uint32_t trigram = 0;
+    int filled = 0; // Bytes in the trigram window, which runs on across chunk boundaries
+    int result = 0;
+
+    initContentView(&view);
+    for (uint64_t position = from; result == 0 && viewFileContent(file, position, size - position, &view) == 0 && view.length > 0; position += view.length)
+    {
+        for (size_t i = 0; i < view.length; ++i)
+        {
+            trigram = (trigram << 8 | (unsigned char)view.data[i]) & 0xFFFFFF;
+            filled += filled < 3;
+            if (filled < 3)
+            {
+                continue;
+            }
+
+            // Keep the table at most three quarters full
+            if ((index->trigram_count + 1) * 4 > index->slot_count * 3 && trigramGrow(index) != 0)
+            {
+                result = -1;
+                break;
+            }
+
+            struct TrigramList *list = &index->slots[trigramSlot(index, trigram)];
+            if (list->trigram == TRIGRAM_EMPTY)
+            {
+                list->trigram = trigram;
+                index->trigram_count++;
+            }
+
+            // No other file is indexed during a scan, so a trigram this scan already posted is
+            // the last posting. One posted by an earlier scan of an append can be anywhere in
+            // the list; it is swapped to the end so later repeats take the quick check.
+            struct TrigramPosting *last = list->count > 0 ? &list->postings[list->count - 1] : NULL;
+            if (last != NULL && last->id == file->id && last->epoch == file->trigram_epoch)
+            {
+                continue;
+            }
+            if (appending)
+            {
+                uint32_t j = list->count;
+                while (j > 0 && (list->postings[j - 1].id != file->id || list->postings[j - 1].epoch != file->trigram_epoch))
+                {
+                    j--;
+                }
+                if (j > 0)
+                {
+                    struct TrigramPosting found = list->postings[j - 1];
+                    list->postings[j - 1] = *last;
+                    *last = found;
+                    continue;
+                }
+            }
+
+            if (list->count == trigramCapacity(list->count))
+            {
+                uint32_t capacity = list->count > 0 ? list->count * 2 : 1;
+                struct TrigramPosting *postings = realloc(list->postings, sizeof(struct TrigramPosting) * capacity);
+                if (postings == NULL)
+                {
+                    result = -1;
+                    break;
+                }
+                list->postings = postings;
+            }
+
+            list->postings[list->count].id = file->id;
+            list->postings[list->count].epoch = file->trigram_epoch;
+            list->count++;
+            file->trigram_count++;
+            index->live_postings++;
+        }
+    }
+
+    freeContentView(&view);
+    index->indexed_bytes += size > from ? size - from : 0;
+    return result;
+}
+
+void trigramForgetFile(struct FileSystem *fs, struct File *file)
+{
+    struct TrigramIndex *index = &fs->trigrams;
+    if (file->trigram_epoch == 0)
+    {
+        return;
+    }
+
+    index->live_postings -= file->trigram_count;
+    index->stale_postings += file->trigram_count;
+    index->indexed_files--;
+    file->trigram_epoch = 0;
+    file->trigram_count = 0;
+}
+
+// (Re)indexes the whole content under a fresh epoch, leaving any older postings stale
+int trigramIndexFile(struct FileSystem *fs, struct File *file)
+{
+    struct TrigramIndex *index = &fs->trigrams;
+    double start = getMilliseconds();
+
+    trigramForgetFile(fs, file);
+    if (++index->epoch == 0)
+    {
+        index->epoch = 1;
+    }
+    file->trigram_epoch = index->epoch;
+    index->indexed_files++;
+
+    int result = trigramScan(fs, file, 0, 0);
+    if (result != 0)
+    {
+        trigramForgetFile(fs, file);
+    }
+    trigramCompact(fs);
+
+    index->build_milliseconds += getMilliseconds() - start;
+    return result;
+}
+
+// Indexes bytes appended from 'from' on; the two bytes before it start trigrams that span the seam
+int trigramIndexAppend(struct FileSystem *fs, struct File *file, size_t from)
+{
+    if (file->trigram_epoch == 0)
+    {
+        return trigramIndexFile(fs, file);
+    }
+
+    double start = getMilliseconds();
+    int result = trigramScan(fs, file, from >= 2 ? from - 2 : 0, 1);
+    if (result != 0)
+    {
+        trigramForgetFile(fs, file);
+    }
+    fs->trigrams.build_milliseconds += getMilliseconds() - start;
+    return result;
+}
+
+// Called after a file's content is replaced. Lazily loaded content stays out of the index
+// until it is indexed again, so recording a file never reads it; grep scans it meanwhile.
+void updateTrigramIndex(struct FileSystem *fs, struct File *file)
+{
+    int deferred = file->small == NULL && file->content != NULL && atomicRead(&file->content->state) != CONTENT_READY;
+    if (isContentIndexed(fs, fs->inodes.parents[file->id]) && !deferred)
+    {
+        trigramIndexFile(fs, file);
+    }
+    else
+    {
+        trigramForgetFile(fs, file);
+    }
+}
+
+// Returns a flag per inode id marking the indexed files that hold every trigram of the
+// pattern, or NULL when the index cannot narrow the search. Files that are not indexed
+// are never marked and must still be scanned.
+unsigned char *trigramCandidates(struct FileSystem *fs, const char *pattern, size_t length)
+{
+    struct TrigramIndex *index = &fs->trigrams;
+    if (index->indexed_files == 0 || length < 3)
+    {
+        return NULL;
+    }
+
+    const struct TrigramList *lists[TRIGRAM_QUERY_MAX];
+    int count = 0;
+    int missing = 0;
+    const unsigned char *bytes = (const unsigned char *)pattern;
+
+    for (size_t i = 0; i + 3 <= length && count < TRIGRAM_QUERY_MAX; ++i)
+    {
+        uint32_t trigram = (uint32_t)bytes[i] << 16 | (uint32_t)bytes[i + 1] << 8 | bytes[i + 2];
+        const struct TrigramList *list = &index->slots[trigramSlot(index, trigram)];
+        if (list->trigram == TRIGRAM_EMPTY)
+        {
+            missing = 1;
+            break;
+        }
+
+        int seen = 0;
+        for (int j = 0; j < count; ++j)
+        {
+            seen |= lists[j] == list;
+        }
+        if (!seen)
+        {
+            // Shortest lists first, so later passes only confirm an already small set
+            int j = count++;
+            while (j > 0 && lists[j - 1]->count > list->count)
+            {
+                lists[j] = lists[j - 1];
+                j--;
+            }
+            lists[j] = list;
+        }
+    }
+
+    unsigned char *marks = calloc(fs->inodes.count > 0 ? fs->inodes.count : 1, 1);
+    if (marks == NULL)
+    {
+        return NULL;
+    }
+    index->queries++;
+
+    if (missing)
+    {
+        return marks; // No indexed file holds one of the trigrams
+    }
+
+    // marks[id] counts the lists the file has been found in so far
+    for (int k = 0; k < count; ++k)
+    {
+        for (uint32_t j = 0; j < lists[k]->count; ++j)
+        {
+            const struct TrigramPosting *posting = &lists[k]->postings[j];
+            if (marks[posting->id] == k && trigramPostingLive(fs, posting))
+            {
+                marks[posting->id] = (unsigned char)(k + 1);
+            }
+        }
+    }
+
+    for (uint32_t id = 0; id < fs->inodes.count; ++id)
+    {
+        marks[id] = marks[id] == count;
+    }
+    return marks;
+}
+
+static size_t trigramIndexBytes(const struct TrigramIndex *index)
+{
+    size_t bytes = index->slot_count * sizeof(struct TrigramList);
+    for (size_t i = 0; i < index->slot_count; ++i)
+    {
+        bytes += (size_t)trigramCapacity(index->slots[i].count) * sizeof(struct TrigramPosting);
+    }
+    return bytes;
+}
+
+// Turns trigram indexing on or off for a subtree and brings its files in line
+void setContentIndexing(struct FileSystem *fs, const char *path, int enable)
+{
+    if (fs == NULL || path == NULL || isWhitespaceString(path))
+    {
+        printf("Invalid parameters provided for content indexing.\n");
+        return;
+    }
+
+    if (strlen(path) >= MAX_PATH_LENGTH)
+    {
+        printf("Path length exceeds maximum limit.\n");
+        return;
+    }
+
+    const char *inputPath = path;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *dir = goTo(fs, inputPath);
+    if (dir == NULL)
+    {
+        printf("Directory not found at path: %s\n", path);
+        return;
+    }
+
+    struct TrigramIndex *index = &fs->trigrams;
+    double start = getMilliseconds();
+    double buildBefore = index->build_milliseconds;
+    uint64_t bytesBefore = index->indexed_bytes;
+    size_t changed = 0;
+    int failed = 0;
+
+    dir->content_indexed = enable;
+
+    uint32_t *stack = malloc(sizeof(uint32_t) * 64);
+    size_t stackCount = 0;
+    size_t stackCapacity = 64;
+    if (stack == NULL)
+    {
+        printf("Memory allocation failed for content indexing.\n");
+        return;
+    }
+    stack[stackCount++] = dir->id;
+
+    while (stackCount > 0)
+    {
+        struct Directory *current = fs->inodes.nodes[stack[--stackCount]];
+        int indexed = isContentIndexed(fs, current->id);
+
+        for (int i = 0; i < current->files.count; ++i)
+        {
+            struct File *file = fs->inodes.nodes[current->files.ids[i]];
+            if (indexed && file->trigram_epoch == 0)
+            {
+                failed |= trigramIndexFile(fs, file) != 0;
+                changed++;
+            }
+            else if (!indexed && file->trigram_epoch != 0)
+            {
+                trigramForgetFile(fs, file);
+                changed++;
+            }
+        }
+
+        if (stackCount + current->subdirectories.count > stackCapacity)
+        {
+            size_t capacity = (stackCount + current->subdirectories.count) * 2;
+            uint32_t *grown = realloc(stack, sizeof(uint32_t) * capacity);
+            if (grown == NULL)
+            {
+                failed = 1;
+                break;
+            }
+            stack = grown;
+            stackCapacity = capacity;
+        }
+        for (int i = 0; i < current->subdirectories.count; ++i)
+        {
+            stack[stackCount++] = current->subdirectories.ids[i];
+        }
+    }
+    free(stack);
+    trigramCompact(fs);
+
+    if (failed)
+    {
+        printf("Memory allocation failed; some files under '%s' are not indexed.\n", path);
+    }
+
+    if (enable)
+    {
+        printf("Indexed %zu files (%llu bytes) under '%s' in %.3f ms (%.3f ms building postings).\n",
+               changed, (unsigned long long)(index->indexed_bytes - bytesBefore), path,
+               getMilliseconds() - start, index->build_milliseconds - buildBefore);
+    }
+    else
+    {
+        printf("Removed %zu files under '%s' from the content index in %.3f ms.\n", changed, path, getMilliseconds() - start);
+    }
+    printf("Trigram index: %zu trigrams, %zu live and %zu stale postings, %zu bytes.\n",
+           index->trigram_count, index->live_postings, index->stale_postings, trigramIndexBytes(index));
+}
+
+// Turns compression of stored content on or off for a subtree and converts what is already
+// there: blocks are compressed or expanded in place, and unchunked content (a file being
+// appended to) is stored into compressed blocks. Blocks are shared, so expanding one also
+// expands it for files outside the subtree.
+void setContentCompression(struct FileSystem *fs, const char *path, int enable)
+{
+    if (fs == NULL || path == NULL || isWhitespaceString(path))
+    {
+        printf("Invalid parameters provided for content compression.\n");
+        return;
+    }
+
+    if (strlen(path) >= MAX_PATH_LENGTH)
+    {
+        printf("Path length exceeds maximum limit.\n");
+        return;
+    }
+
+    const char *inputPath = path;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *dir = goTo(fs, inputPath);
+    if (dir == NULL)
+    {
+        printf("Directory not found at path: %s\n", path);
+        return;
+    }
+
+    struct BlockStore *store = &fs->blocks;
+    double start = getMilliseconds();
+    uint64_t storedBefore = store->stored_bytes;
+    size_t changed = 0;
+    int failed = 0;
+
+    dir->compressed = enable;
+
+    uint32_t *stack = malloc(sizeof(uint32_t) * 64);
+    size_t stackCount = 0;
+    size_t stackCapacity = 64;
+    if (stack == NULL)
+    {
+        printf("Memory allocation failed for content compression.\n");
+        return;
+    }
+    stack[stackCount++] = dir->id;
+
+    while (stackCount > 0)
+    {
+        struct Directory *current = fs->inodes.nodes[stack[--stackCount]];
+        int compress = isContentCompressed(fs, current->id);
+
+        for (int i = 0; i < current->files.count; ++i)
+        {
+            struct File *file = fs->inodes.nodes[current->files.ids[i]];
+            struct Content *content = file->content;
+            if (content == NULL)
+            {
+                continue;
+            }
+
+            if (content->store != NULL)
+            {
+                for (uint32_t b = 0; b < content->block_count; ++b)
+                {
+                    failed |= convertBlock(store, content->blocks[b].block, compress) != 0;
+                }
+                changed++;
+            }
+            else if (compress && !content->writable && content->state == CONTENT_READY) // Writable or unread files stay on their host file
+            {
+                char *gathered;
+                const char *bytes = contiguousFileContent(file, &gathered);
+                failed |= bytes == NULL || setFileContent(fs, file, bytes, file->size) != 0;
+                free(gathered);
+                changed++;
+            }
+        }
+
+        if (stackCount + current->subdirectories.count > stackCapacity)
+        {
+            size_t capacity = (stackCount + current->subdirectories.count) * 2;
+            uint32_t *grown = realloc(stack, sizeof(uint32_t) * capacity);
+            if (grown == NULL)
+            {
+                failed = 1;
+                break;
+            }
+            stack = grown;
+            stackCapacity = capacity;
+        }
+        for (int i = 0; i < current->subdirectories.count; ++i)
+        {
+            stack[stackCount++] = current->subdirectories.ids[i];
+        }
+    }
+    free(stack);
+
+    if (failed)
+    {
+        printf("Memory allocation failed; some content under '%s' was not converted.\n", path);
+    }
+
+    printf("%s content of %zu files under '%s' in %.3f ms; stored bytes went from %llu to %llu.\n",
+           enable ? "Compressed" : "Expanded", changed, path, getMilliseconds() - start,
+           (unsigned long long)storedBefore, (unsigned long long)store->stored_bytes);
+    printf("Compressed blocks: %zu, %llu bytes stored as %llu (%.2fx).\n", store->compressed_blocks,
+           (unsigned long long)store->compressed_input_bytes, (unsigned long long)store->compressed_bytes,
+           store->compressed_bytes > 0 ? (double)store->compressed_input_bytes / store->compressed_bytes : 1.0);
+}
+
+void moveDirectoryAtPath(struct FileSystem *fs, const char *sourcePath, const char *destinationPath)
+{
+    if (fs == NULL || sourcePath == NULL || destinationPath == NULL ||
+        isWhitespaceString(sourcePath) || isWhitespaceString(destinationPath))
+    {
+        printf("Invalid parameters provided. Cannot move directory.\n");
+        return;
+    }
+
+    // Check for potential buffer overflow in the paths
+    if (strlen(sourcePath) >= MAX_PATH_LENGTH || strlen(destinationPath) >= MAX_PATH_LENGTH)
+    {
+        printf("Path length exceeds maximum limit.\n");
+        return;
+    }
+
+    char *inputSourcePath = sourcePath;
+    char *inputDestPath = destinationPath;
+
+    if (strcmp(inputSourcePath, ".") == 0)
+    {
+        inputSourcePath = getCurrentDirectoryPath(fs);
+    }
+
+    if (strcmp(inputDestPath, ".") == 0)
+    {
+        // Stay in the current directory
+        inputDestPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *sourceDir = goTo(fs, inputSourcePath);
+    struct Directory *destinationDir = goTo(fs, inputDestPath);
+
+    if (sourceDir != NULL && destinationDir != NULL)
+    {
+        uint32_t sourceId = sourceDir->id;
+        uint32_t parentId = fs->inodes.parents[sourceId];
+
+        if (parentId == INODE_NONE)
+        {
+            printf("Directory '%s' cannot be moved.\n", nodeName(fs, sourceId));
+            return;
+        }
+
+        // Refuse to move a directory underneath itself
+        for (uint32_t id = destinationDir->id; id != INODE_NONE; id = fs->inodes.parents[id])
+        {
+            if (id == sourceId)
+            {
+                printf("Cannot move directory '%s' into its own subtree.\n", nodeName(fs, sourceId));
+                return;
+            }
+        }
+
+        if (findSubdirectory(fs, destinationDir, nodeName(fs, sourceId)) != NULL)
+        {
+            printf("Directory '%s' already exists in '%s'. Cannot move.\n", nodeName(fs, sourceId), nodeName(fs, destinationDir->id));
+            return;
+        }
+
+        // Paths are derived from parent ids, so relinking the subtree root moves the whole subtree
+        struct Directory *parentDir = fs->inodes.nodes[parentId];
+        if (childIndexInsert(&fs->inodes, &destinationDir->subdirectories, sourceId) != 0)
+        {
+            printf("Memory allocation failed while moving directory '%s'.\n", nodeName(fs, sourceId));
+            return;
+        }
+        childIndexRemove(&fs->inodes, &parentDir->subdirectories, nodeName(fs, sourceId));
+        fs->inodes.parents[sourceId] = destinationDir->id;
+
+        // Cached lookups may point into the subtree that was relinked
+        invalidateDentryCache(fs);
+
+        printf("Directory '%s' moved to '%s'.\n", nodeName(fs, sourceId), nodeName(fs, destinationDir->id));
+    }
+    else
+    {
+        printf("Invalid source or destination directory. Cannot move.\n");
+    }
+}
+
+void renameDirectoryAtPath(struct FileSystem *fs, const char *path, const char *newName)
+{
+    if (fs == NULL || path == NULL || newName == NULL || isWhitespaceString(path) || isWhitespaceString(newName))
     {
-        return 1;
+        printf("Invalid parameters provided. Cannot rename directory.\n");
+        return;
+    }
+
+    if (strlen(path) >= MAX_PATH_LENGTH || strlen(newName) >= MAX_FILE_NAME_LENGTH || strchr(newName, '/') != NULL)
+    {
+        printf("Invalid path or directory name length.\n");
+        return;
+    }
+
+    const char *inputPath = path;
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        inputPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *dir = goTo(fs, inputPath);
+    if (dir == NULL)
+    {
+        printf("Directory not found at path: %s\n", path);
+        return;
+    }
+
+    uint32_t parentId = fs->inodes.parents[dir->id];
+    if (parentId == INODE_NONE)
+    {
+        printf("Directory '%s' cannot be renamed.\n", nodeName(fs, dir->id));
+        return;
+    }
+
+    struct Directory *parentDir = fs->inodes.nodes[parentId];
+    if (findSubdirectory(fs, parentDir, newName) != NULL)
+    {
+        printf("Directory '%s' already exists in '%s'. Cannot rename.\n", newName, nodeName(fs, parentId));
+        return;
+    }
+
+    const char *interned = internName(&fs->names, newName);
+    if (interned == NULL)
+    {
+        printf("Memory allocation failed while renaming directory.\n");
+        return;
+    }
+
+    const char *oldName = nodeName(fs, dir->id);
+    childIndexRemove(&fs->inodes, &parentDir->subdirectories, oldName);
+    fs->inodes.names[dir->id] = interned;
+    if (childIndexInsert(&fs->inodes, &parentDir->subdirectories, dir->id) != 0)
+    {
+        // Put the old name back so the directory stays reachable
+        fs->inodes.names[dir->id] = oldName;
+        childIndexInsert(&fs->inodes, &parentDir->subdirectories, dir->id);
+        releaseName(&fs->names, interned);
+        printf("Memory allocation failed while renaming directory.\n");
+        return;
+    }
+
+    invalidateDentryCache(fs);
+    printf("Directory '%s' renamed to '%s'.\n", oldName, interned);
+    releaseName(&fs->names, oldName);
+}
+
+void moveFileAtPath(struct FileSystem *fs, const char *sourcePath, const char *destinationPath, const char *fileName)
+{
+    if (fs == NULL || sourcePath == NULL || destinationPath == NULL || fileName == NULL ||
+        isWhitespaceString(sourcePath) || isWhitespaceString(destinationPath) || isWhitespaceString(fileName))
+    {
+        printf("Invalid parameters provided. Cannot move file.\n");
+        return;
+    }
+
+    // Check for potential buffer overflow in the paths and fileName
+    if (strlen(sourcePath) >= MAX_PATH_LENGTH || strlen(destinationPath) >= MAX_PATH_LENGTH || strlen(fileName) >= MAX_FILE_NAME_LENGTH)
+    {
+        printf("Path or file name length exceeds maximum limit.\n");
+        return;
+    }
+
+    char *inputSourcePath = sourcePath;
+    char *inputDestPath = destinationPath;
+
+    if (strcmp(inputSourcePath, ".") == 0)
+    {
+        inputSourcePath = getCurrentDirectoryPath(fs);
+    }
+
+    if (strcmp(inputDestPath, ".") == 0)
+    {
+        // Stay in the current directory
+        inputDestPath = getCurrentDirectoryPath(fs);
+    }
+
+    struct Directory *sourceDir = goTo(fs, inputSourcePath);
+    struct Directory *destinationDir = goTo(fs, inputDestPath);
+
+    if (sourceDir != NULL && destinationDir != NULL)
+    {
+        // Binary search in source directory to find the file
+        struct File *fileToMove = findFile(fs, sourceDir, fileName);
+
+        if (fileToMove != NULL)
+        {
+            // Check if the destination directory already contains a file with the same name
+            if (findFile(fs, destinationDir, fileName) != NULL)
+            {
+                printf("File '%s' already exists in '%s'. Cannot move.\n", fileName, nodeName(fs, destinationDir->id));
+                return;
+            }
+
+            // Add file to the destination directory
+            if (childIndexInsert(&fs->inodes, &destinationDir->files, fileToMove->id) != 0)
+            {
+                printf("Memory allocation failed while moving file '%s'.\n", fileName);
+                return;
+            }
+            childIndexRemove(&fs->inodes, &sourceDir->files, fileName);
+            fs->inodes.parents[fileToMove->id] = destinationDir->id;
+
+            printf("File '%s' moved from '%s' to '%s'.\n", fileName, nodeName(fs, sourceDir->id), nodeName(fs, destinationDir->id));
+        }
+        else
+        {
+            printf("File '%s' not found in '%s'. Cannot move.\n", fileName, nodeName(fs, sourceDir->id));
+        }
     }
+    else
+    {
+        printf("Invalid parameters provided. Cannot move file.\n");
+    }
+}
+
+// Gives a fresh copy the same content as its source: shared bytes, plus trigram postings if the copy lands in an indexed directory
+static struct File *copyFileNode(struct FileSystem *fs, const struct File *source, struct Directory *destinationDir)
+{
+    struct File *copy = newFileNode(fs, destinationDir, nodeName(fs, source->id));
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+
+    if (shareFileContent(fs, copy, source) != 0)
+    {
+        childIndexRemove(&fs->inodes, &destinationDir->files, nodeName(fs, copy->id));
+        nameIndexRemove(fs, copy->id);
+        freeInode(fs, copy->id);
+        slabFree(&fs->file_slab, copy);
+        return NULL;
+    }
+    if (isContentIndexed(fs, destinationDir->id))
+    {
+        trigramIndexFile(fs, copy);
+    }
+    return copy;
+}
+
+void copyFileToPath(struct FileSystem *fs, const char *sourcePath, const char *fileName, const char *destinationPath)
+{
+    if (fs == NULL || sourcePath == NULL || fileName == NULL || destinationPath == NULL ||
+        isWhitespaceString(sourcePath) || isWhitespaceString(fileName) || isWhitespaceString(destinationPath))
+    {
+        printf("Invalid parameters provided. Cannot copy file.\n");
+        return;
+    }
+
+    if (strlen(sourcePath) >= MAX_PATH_LENGTH || strlen(destinationPath) >= MAX_PATH_LENGTH || strlen(fileName) >= MAX_FILE_NAME_LENGTH)
+    {
+        printf("Path or file name length exceeds maximum limit.\n");
+        return;
+    }
+
+    struct Directory *sourceDir = goTo(fs, sourcePath);
+    struct Directory *destinationDir = goTo(fs, destinationPath);
+    if (sourceDir == NULL || destinationDir == NULL)
+    {
+        printf("Source or destination directory not found. Cannot copy file.\n");
+        return;
+    }
+
+    struct File *source = findFile(fs, sourceDir, fileName);
+    if (source == NULL)
+    {
+        printf("File '%s' not found in '%s'. Cannot copy.\n", fileName, sourcePath);
+        return;
+    }
+
+    if (findFile(fs, destinationDir, fileName) != NULL)
+    {
+        printf("File '%s' already exists in '%s'. Cannot copy.\n", fileName, nodeName(fs, destinationDir->id));
+        return;
+    }
+
+    if (copyFileNode(fs, source, destinationDir) == NULL)
+    {
+        printf("Memory allocation failed while copying file '%s'.\n", fileName);
+        return;
+    }
+
+    printf("File '%s' copied from '%s' to '%s' (%llu bytes shared).\n",
+           fileName, nodeName(fs, sourceDir->id), nodeName(fs, destinationDir->id), (unsigned long long)source->size);
+}
+
+// Copies a directory and everything below it into the destination. Only nodes are created;
+// every copied file shares its source's content until one of them is written.
+void copyDirectoryToPath(struct FileSystem *fs, const char *sourcePath, const char *destinationPath)
+{
+    if (fs == NULL || sourcePath == NULL || destinationPath == NULL || isWhitespaceString(sourcePath) || isWhitespaceString(destinationPath))
+    {
+        printf("Invalid parameters provided. Cannot copy directory.\n");
+        return;
+    }
+
+    if (strlen(sourcePath) >= MAX_PATH_LENGTH || strlen(destinationPath) >= MAX_PATH_LENGTH)
+    {
+        printf("Path length exceeds maximum limit.\n");
+        return;
+    }
+
+    struct Directory *sourceDir = goTo(fs, sourcePath);
+    struct Directory *destinationDir = goTo(fs, destinationPath);
+    if (sourceDir == NULL || destinationDir == NULL)
+    {
+        printf("Source or destination directory not found. Cannot copy directory.\n");
+        return;
+    }
+
+    if (sourceDir == fs->root)
+    {
+        printf("Directory '%s' cannot be copied.\n", nodeName(fs, sourceDir->id));
+        return;
+    }
+
+    if (isInSubtree(fs, destinationDir->id, sourceDir->id))
+    {
+        printf("Cannot copy directory '%s' into its own subtree.\n", nodeName(fs, sourceDir->id));
+        return;
+    }
+
+    if (findSubdirectory(fs, destinationDir, nodeName(fs, sourceDir->id)) != NULL)
+    {
+        printf("Directory '%s' already exists in '%s'. Cannot copy.\n", nodeName(fs, sourceDir->id), nodeName(fs, destinationDir->id));
+        return;
+    }
+
+    double start = getMilliseconds();
+    size_t directories = 0;
+    size_t files = 0;
+    uint64_t sharedBytes = 0;
+    int failed = 0;
+
+    // Pairs of (source, copy) directory ids still to fill
+    uint32_t *stack = malloc(sizeof(uint32_t) * 2 * 64);
+    size_t stackCount = 0;
+    size_t stackCapacity = 64;
+    struct Directory *top = stack != NULL ? newDirectoryNode(fs, destinationDir, nodeName(fs, sourceDir->id)) : NULL;
+    if (top == NULL)
+    {
+        printf("Memory allocation failed while copying directory '%s'.\n", nodeName(fs, sourceDir->id));
+        free(stack);
+        return;
+    }
+    top->access = sourceDir->access;
+    top->content_indexed = sourceDir->content_indexed;
+    top->compressed = sourceDir->compressed;
+    directories++;
+    stack[0] = sourceDir->id;
+    stack[1] = top->id;
+    stackCount = 1;
+
+    while (stackCount > 0 && !failed)
+    {
+        stackCount--;
+        struct Directory *source = fs->inodes.nodes[stack[2 * stackCount]];
+        struct Directory *copy = fs->inodes.nodes[stack[2 * stackCount + 1]];
+
+        for (int i = 0; i < source->files.count; ++i)
+        {
+            struct File *file = fs->inodes.nodes[source->files.ids[i]];
+            if (copyFileNode(fs, file, copy) == NULL)
+            {
+                failed = 1;
+                break;
+            }
+            sharedBytes += file->size;
+            files++;
+        }
+
+        for (int i = 0; i < source->subdirectories.count && !failed; ++i)
+        {
+            struct Directory *subdir = fs->inodes.nodes[source->subdirectories.ids[i]];
+            struct Directory *subdirCopy = newDirectoryNode(fs, copy, nodeName(fs, subdir->id));
+            if (subdirCopy == NULL)
+            {
+                failed = 1;
+                break;
+            }
+            subdirCopy->access = subdir->access;
+            subdirCopy->content_indexed = subdir->content_indexed;
+            subdirCopy->compressed = subdir->compressed;
+            directories++;
+
+            if (stackCount == stackCapacity)
+            {
+                uint32_t *grown = realloc(stack, sizeof(uint32_t) * 2 * stackCapacity * 2);
+                if (grown == NULL)
+                {
+                    failed = 1;
+                    break;
+                }
+                stack = grown;
+                stackCapacity *= 2;
+            }
+            stack[2 * stackCount] = subdir->id;
+            stack[2 * stackCount + 1] = subdirCopy->id;
+            stackCount++;
+        }
+    }
+    free(stack);
+
+    char copyPath[MAX_PATH_LENGTH];
+    buildDirectoryPath(fs, top->id, copyPath, sizeof(copyPath));
+    if (failed)
+    {
+        printf("Memory allocation failed; '%s' is a partial copy.\n", copyPath);
+    }
+    printf("Directory copied to '%s': %zu directories and %zu files, %llu bytes shared in %.3f ms.\n",
+           copyPath, directories, files, (unsigned long long)sharedBytes, getMilliseconds() - start);
+}
+
+static int compareStrings(const void *a, const void *b)
+{
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+void searchFileInPath(struct FileSystem *fs, const char *path, const char *fileName)
+{
+    if (fs == NULL || path == NULL || fileName == NULL || isWhitespaceString(path) || isWhitespaceString(fileName))
+    {
+        printf("Invalid parameters provided for file search.\n");
+        return;
+    }
+
+    // Check for potential buffer overflow in the path and fileName
+    if (strlen(path) >= MAX_PATH_LENGTH || strlen(fileName) >= MAX_FILE_NAME_LENGTH)
+    {
+        printf("Path or file name length exceeds maximum limit.\n");
+        return;
+    }
+
+    struct Directory *currentDir = goTo(fs, path);
+
+    if (currentDir != NULL)
+    {
+        // Every file with this name comes from the name index; only those under 'path' are reported
+        const struct NamePosting *posting = nameIndexLookup(&fs->name_index, fileName);
+        char **paths = posting != NULL ? malloc(sizeof(char *) * posting->count) : NULL;
+        uint32_t found = 0;
+
+        if (posting != NULL && paths == NULL)
+        {
+            printf("Memory allocation failed for file search.\n");
+            return;
+        }
 
-    int charCount = 0;
-    while (*str != '\0')
-    {
-        if (charCount >= MAX_CHARS)
+        for (uint32_t i = 0; posting != NULL && i < posting->count; ++i)
         {
-            printf("Exceeded maximum character count (%d).\n", MAX_CHARS);
-            return 0;
+            uint32_t parentId = fs->inodes.parents[posting->ids[i]];
+            if (isInSubtree(fs, parentId, currentDir->id))
+            {
+                size_t length = buildDirectoryPath(fs, parentId, NULL, 0);
+                paths[found] = malloc(length + 1);
+                if (paths[found] != NULL)
+                {
+                    buildDirectoryPath(fs, parentId, paths[found], length + 1);
+                    found++;
+                }
+            }
         }
 
-        if (!isspace((unsigned char)*str))
+        // The index keeps no order, so sort the hits to print them the same way every time
+        qsort(paths, found, sizeof(char *), compareStrings);
+        for (uint32_t i = 0; i < found; ++i)
         {
-            return 0;
+            printf("File '%s' found at path: %s\n", fileName, paths[i]);
+            free(paths[i]);
         }
-        str++;
-        charCount++;
+        free(paths);
+
+        if (found == 0)
+        {
+            printf("File '%s' not found in path: %s\n", fileName, path);
+        }
+    }
+    else
+    {
+        printf("Invalid parameters provided for file search.\n");
     }
+}
 
-    return 1;
+#ifdef FSYS_HAVE_SSE2
+static unsigned int lowestSetBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctz(mask);
+#endif
 }
+#endif
 
-void addUserToSystem(struct FileSystem *fs, const char *username,
-                     const char *password, enum AuthorityLevel accessLevel)
+// Finds the first occurrence of 'literal' in 'data'. With SSE2, 16 candidate positions are
+// tested at once on the literal's first and last byte before any memcmp.
+const char *findLiteral(const char *data, size_t length, const char *literal, size_t literalLength)
 {
-    if (username == NULL || isWhitespaceString(username) || strlen(username) >= MAX_USERNAME_LENGTH ||
-        password == NULL || strlen(password) >= MAX_PASSWORD_LENGTH)
+    if (literalLength == 0)
     {
-        printf("Invalid or too long username or password provided.\n");
-        return;
+        return data;
+    }
+    if (literalLength > length)
+    {
+        return NULL;
     }
 
-    if (fs->user_count < MAX_USERS)
+    size_t last = literalLength - 1;
+    size_t position = 0;
+
+#ifdef FSYS_HAVE_SSE2
+    __m128i first = _mm_set1_epi8(literal[0]);
+    __m128i final = _mm_set1_epi8(literal[last]);
+
+    for (; position + last + 16 <= length; position += 16)
     {
-        strncpy(fs->users[fs->user_count].username, username, MAX_USERNAME_LENGTH - 1);
-        strncpy(fs->users[fs->user_count].password, password, MAX_PASSWORD_LENGTH - 1);
-        fs->users[fs->user_count].access_level = accessLevel;
-        fs->user_count++;
-        printf("User added successfully.\n");
+        __m128i head = _mm_loadu_si128((const __m128i *)(data + position));
+        __m128i tail = _mm_loadu_si128((const __m128i *)(data + position + last));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, final)));
+
+        while (mask != 0)
+        {
+            unsigned int bit = lowestSetBit(mask);
+            if (last < 2 || memcmp(data + position + bit + 1, literal + 1, last - 1) == 0)
+            {
+                return data + position + bit;
+            }
+            mask &= mask - 1;
+        }
     }
-    else
+#endif
+
+    while (position + literalLength <= length)
     {
-        printf("Cannot add more users. Maximum capacity reached.\n");
+        const char *hit = memchr(data + position, literal[0], length - literalLength + 1 - position);
+        if (hit == NULL)
+        {
+            return NULL;
+        }
+        if (memcmp(hit, literal, literalLength) == 0)
+        {
+            return hit;
+        }
+        position = (size_t)(hit - data) + 1;
     }
+    return NULL;
 }
 
-void deleteUserFromSystem(struct FileSystem *fs, const char *username)
+enum RegexNodeType
 {
-    if (username == NULL || isWhitespaceString(username) || strlen(username) >= MAX_USERNAME_LENGTH)
+    RNODE_EMPTY,
+    RNODE_CHAR,
+    RNODE_ANY,
+    RNODE_CLASS,
+    RNODE_BOL,
+    RNODE_EOL,
+    RNODE_CAT,
+    RNODE_ALT,
+    RNODE_STAR,
+    RNODE_PLUS,
+    RNODE_QUEST
+};
+
+enum RegexOp
+{
+    REGEX_CHAR,
+    REGEX_ANY,
+    REGEX_CLASS,
+    REGEX_BOL,
+    REGEX_EOL,
+    REGEX_SPLIT,
+    REGEX_JMP,
+    REGEX_MATCH
+};
+
+struct RegexNode
+{
+    enum RegexNodeType type;
+    int left;
+    int right;
+    unsigned char c;
+    int cls;
+};
+
+// Both pattern syntaxes are parsed into the same tree and compiled to the same program
+struct PatternParser
+{
+    const char *p;
+    struct RegexNode *nodes;
+    int count;
+    int capacity;
+    struct NamePattern *pattern;
+    int error;
+};
+
+static int patternNode(struct PatternParser *parser, enum RegexNodeType type, int left, int right, unsigned char c)
+{
+    if (parser->count == parser->capacity)
     {
-        printf("Invalid or too long username provided.\n");
-        return;
+        int capacity = parser->capacity > 0 ? parser->capacity * 2 : 64;
+        struct RegexNode *nodes = realloc(parser->nodes, sizeof(struct RegexNode) * capacity);
+        if (nodes == NULL)
+        {
+            parser->error = 1;
+            return -1;
+        }
+        parser->nodes = nodes;
+        parser->capacity = capacity;
     }
 
-    int found = 0;
-    for (int i = 0; i < fs->user_count; ++i)
+    struct RegexNode *node = &parser->nodes[parser->count];
+    node->type = type;
+    node->left = left;
+    node->right = right;
+    node->c = c;
+    node->cls = -1;
+    return parser->count++;
+}
+
+// Parses "[...]" starting at '['; returns -1 and consumes nothing if the class is not closed
+static int patternClass(struct PatternParser *parser, const char *negators)
+{
+    const char *p = parser->p + 1;
+    unsigned char set[32] = {0};
+    int negate = 0;
+
+    if (*p != '\0' && strchr(negators, *p) != NULL)
     {
-        if (strcmp(username, fs->users[i].username) == 0)
+        negate = 1;
+        p++;
+    }
+
+    int first = 1;
+    while (*p != '\0' && (*p != ']' || first))
+    {
+        unsigned char low = (unsigned char)*p;
+        if (low == '\\' && p[1] != '\0')
         {
-            found = 1;
-            // Shift elements in the array starting from the found index
-            for (int j = i; j < fs->user_count - 1; ++j)
-            {
-                strcpy(fs->users[j].username, fs->users[j + 1].username);
-                strcpy(fs->users[j].password, fs->users[j + 1].password);
-                fs->users[j].access_level = fs->users[j + 1].access_level;
-            }
-            // Clear the last element in the array
-            memset(&fs->users[fs->user_count - 1], 0, sizeof(struct User));
-            fs->user_count--;
-            printf("User '%s' deleted successfully.\n", username);
-            break;
+            low = (unsigned char)*++p;
+        }
+        unsigned char high = low;
+        if (p[1] == '-' && p[2] != '\0' && p[2] != ']')
+        {
+            high = (unsigned char)p[2];
+            p += 2;
+        }
+        for (unsigned int c = low; c <= high; ++c)
+        {
+            set[c >> 3] |= (unsigned char)(1u << (c & 7));
         }
+        p++;
+        first = 0;
     }
 
-    if (!found)
+    if (*p != ']')
     {
-        printf("User '%s' not found in the system.\n", username);
+        return -1;
     }
-}
 
-void startTimerForUser(struct Timer *timer, int delaySeconds)
-{
-    timer->startTime = time(NULL);
-    timer->delayDuration = delaySeconds;
+    struct NamePattern *pattern = parser->pattern;
+    unsigned char (*classes)[32] = realloc(pattern->classes, sizeof(*classes) * (pattern->class_count + 1));
+    if (classes == NULL)
+    {
+        parser->error = 1;
+        return -1;
+    }
+    pattern->classes = classes;
+
+    for (int i = 0; i < 32; ++i)
+    {
+        classes[pattern->class_count][i] = negate ? (unsigned char)~set[i] : set[i];
+    }
+    classes[pattern->class_count][0] &= (unsigned char)~1u; // Never matches the terminator
+
+    int node = patternNode(parser, RNODE_CLASS, -1, -1, 0);
+    if (node >= 0)
+    {
+        parser->nodes[node].cls = pattern->class_count++;
+    }
+    parser->p = p + 1;
+    return node;
 }
 
-int isUserTimerExpired(struct Timer *timer)
+static int regexParseAlternation(struct PatternParser *parser);
+
+static int regexParseAtom(struct PatternParser *parser)
 {
-    time_t currentTime = time(NULL);
-    return (currentTime - timer->startTime >= timer->delayDuration);
+    char c = *parser->p;
+
+    switch (c)
+    {
+    case '(':
+    {
+        parser->p++;
+        int node = regexParseAlternation(parser);
+        if (*parser->p != ')')
+        {
+            parser->error = 1;
+            return -1;
+        }
+        parser->p++;
+        return node;
+    }
+    case '[':
+    {
+        int node = patternClass(parser, "^");
+        if (node < 0)
+        {
+            parser->error = 1;
+        }
+        return node;
+    }
+    case '*':
+    case '+':
+    case '?':
+        parser->error = 1; // Nothing to repeat
+        return -1;
+    case '.':
+        parser->p++;
+        return patternNode(parser, RNODE_ANY, -1, -1, 0);
+    case '^':
+        parser->p++;
+        return patternNode(parser, RNODE_BOL, -1, -1, 0);
+    case '$':
+        parser->p++;
+        return patternNode(parser, RNODE_EOL, -1, -1, 0);
+    case '\\':
+        if (parser->p[1] == '\0')
+        {
+            parser->error = 1;
+            return -1;
+        }
+        parser->p += 2;
+        return patternNode(parser, RNODE_CHAR, -1, -1, (unsigned char)parser->p[-1]);
+    default:
+        parser->p++;
+        return patternNode(parser, RNODE_CHAR, -1, -1, (unsigned char)c);
+    }
 }
 
-struct User loginUser(struct FileSystem *fs, const char *username)
+static int regexParseRepeat(struct PatternParser *parser)
 {
-    if (fs == NULL || username == NULL || isWhitespaceString(username))
+    int node = regexParseAtom(parser);
+
+    while (!parser->error && (*parser->p == '*' || *parser->p == '+' || *parser->p == '?'))
     {
-        printf("Invalid parameters provided for login.\n");
-        struct User emptyUser = {"", "", LOW, 0}; // Return an empty user if login fails
-        return emptyUser;
+        enum RegexNodeType type = *parser->p == '*' ? RNODE_STAR : *parser->p == '+' ? RNODE_PLUS : RNODE_QUEST;
+        parser->p++;
+        node = patternNode(parser, type, node, -1, 0);
     }
+    return node;
+}
 
-    if (strlen(username) >= MAX_USERNAME_LENGTH)
+static int regexParseConcatenation(struct PatternParser *parser)
+{
+    int node = -1;
+
+    while (!parser->error && *parser->p != '\0' && *parser->p != '|' && *parser->p != ')')
     {
-        printf("Username length exceeds maximum limit.\n");
-        struct User emptyUser = {"", "", LOW, 0}; // Return an empty user if login fails
-        return emptyUser;
+        int next = regexParseRepeat(parser);
+        node = node < 0 ? next : patternNode(parser, RNODE_CAT, node, next, 0);
     }
+    return node < 0 ? patternNode(parser, RNODE_EMPTY, -1, -1, 0) : node;
+}
 
-    struct User *currentUser = NULL;
+static int regexParseAlternation(struct PatternParser *parser)
+{
+    int node = regexParseConcatenation(parser);
 
-    for (int i = 0; i < fs->user_count; ++i)
+    while (!parser->error && *parser->p == '|')
     {
-        if (strcmp(username, fs->users[i].username) == 0)
-        {
-            currentUser = &fs->users[i];
-            break;
-        }
+        parser->p++;
+        int right = regexParseConcatenation(parser);
+        node = patternNode(parser, RNODE_ALT, node, right, 0);
     }
+    return node;
+}
 
-    if (currentUser != NULL)
+// A glob is anchored at both ends: ^...$ around its characters
+static int globParse(struct PatternParser *parser)
+{
+    int node = patternNode(parser, RNODE_BOL, -1, -1, 0);
+
+    while (!parser->error && *parser->p != '\0')
     {
-        for (int i = 0; i < currentUser->delayParams.delayedUsersCount; ++i)
+        int next;
+        char c = *parser->p;
+
+        if (c == '*')
         {
-            if (isUserTimerExpired(&(currentUser->delayParams.delayedUsers[i].timer)))
+            while (*parser->p == '*')
             {
-                currentUser->delayParams.delayedUsers[i].penaltyDelaySeconds = 0;
+                parser->p++;
             }
+            next = patternNode(parser, RNODE_STAR, patternNode(parser, RNODE_ANY, -1, -1, 0), -1, 0);
         }
-
-        int totalDelay = 0;
-        for (int i = 0; i < currentUser->delayParams.delayedUsersCount; ++i)
+        else if (c == '?')
         {
-            totalDelay += currentUser->delayParams.delayedUsers[i].penaltyDelaySeconds;
+            parser->p++;
+            next = patternNode(parser, RNODE_ANY, -1, -1, 0);
         }
-
-        if (totalDelay > 0)
+        else if (c == '[' && (next = patternClass(parser, "!^")) >= 0)
         {
-            printf("Login failed. Users are delayed. Retry after %d seconds.\n", totalDelay);
-            struct User emptyUser = {"", "", LOW, 0};
-            return emptyUser;
+            // Class parsed
         }
-
-        printf("Enter password: ");
-        char password[MAX_PASSWORD_LENGTH];
-        int index = 0;
-        char ch;
-        while ((ch = _getch()) != '\r' && index < MAX_PASSWORD_LENGTH - 1)
+        else
         {
-            if (ch == '\b' && index > 0)
-            {
-                printf("\b \b");
-                index--;
-            }
-            else if (ch != '\b')
+            if (c == '\\' && parser->p[1] != '\0')
             {
-                printf("*");
-                password[index++] = ch;
+                c = *++parser->p;
             }
+            parser->p++;
+            next = patternNode(parser, RNODE_CHAR, -1, -1, (unsigned char)c);
         }
-        password[index] = '\0';
-        printf("\n");
+        node = patternNode(parser, RNODE_CAT, node, next, 0);
+    }
+    return patternNode(parser, RNODE_CAT, node, patternNode(parser, RNODE_EOL, -1, -1, 0), 0);
+}
 
-        if (strcmp(password, currentUser->password) == 0)
+static int regexEmit(struct NamePattern *pattern, int *capacity, enum RegexOp op, unsigned char c, int x, int y)
+{
+    if (pattern->program_length >= REGEX_MAX_PROGRAM)
+    {
+        return -1;
+    }
+    if (pattern->program_length == *capacity)
+    {
+        int newCapacity = *capacity > 0 ? *capacity * 2 : 64;
+        struct RegexInstruction *program = realloc(pattern->program, sizeof(struct RegexInstruction) * newCapacity);
+        if (program == NULL)
         {
-            printf("Logged in successfully as %s with level %d.\n", username, currentUser->access_level);
-            currentUser->login_attempts = 0; // Reset login attempts
-            // Update the current user in the file system
-            fs->current_user = *currentUser;
-            // Return the logged-in user
-            return *currentUser;
+            return -1;
         }
-        else
+        pattern->program = program;
+        *capacity = newCapacity;
+    }
+
+    struct RegexInstruction *instruction = &pattern->program[pattern->program_length];
+    instruction->op = (unsigned char)op;
+    instruction->c = c;
+    instruction->x = (unsigned short)x;
+    instruction->y = (unsigned short)y;
+    return pattern->program_length++;
+}
+
+static int regexCompileNode(struct NamePattern *pattern, int *capacity, const struct RegexNode *nodes, int index)
+{
+    const struct RegexNode *node = &nodes[index];
+    int split;
+    int jump;
+
+    switch (node->type)
+    {
+    case RNODE_EMPTY:
+        return 0;
+    case RNODE_CHAR:
+        return regexEmit(pattern, capacity, REGEX_CHAR, node->c, 0, 0) < 0 ? -1 : 0;
+    case RNODE_ANY:
+        return regexEmit(pattern, capacity, REGEX_ANY, 0, 0, 0) < 0 ? -1 : 0;
+    case RNODE_CLASS:
+        return regexEmit(pattern, capacity, REGEX_CLASS, 0, node->cls, 0) < 0 ? -1 : 0;
+    case RNODE_BOL:
+        return regexEmit(pattern, capacity, REGEX_BOL, 0, 0, 0) < 0 ? -1 : 0;
+    case RNODE_EOL:
+        return regexEmit(pattern, capacity, REGEX_EOL, 0, 0, 0) < 0 ? -1 : 0;
+    case RNODE_CAT:
+        if (regexCompileNode(pattern, capacity, nodes, node->left) < 0)
         {
-            currentUser->login_attempts++;
+            return -1;
+        }
+        return regexCompileNode(pattern, capacity, nodes, node->right);
+    case RNODE_ALT:
+        // split L1, L2; L1: left; jmp L3; L2: right; L3:
+        if ((split = regexEmit(pattern, capacity, REGEX_SPLIT, 0, 0, 0)) < 0)
+        {
+            return -1;
+        }
+        pattern->program[split].x = (unsigned short)pattern->program_length;
+        if (regexCompileNode(pattern, capacity, nodes, node->left) < 0 || (jump = regexEmit(pattern, capacity, REGEX_JMP, 0, 0, 0)) < 0)
+        {
+            return -1;
+        }
+        pattern->program[split].y = (unsigned short)pattern->program_length;
+        if (regexCompileNode(pattern, capacity, nodes, node->right) < 0)
+        {
+            return -1;
+        }
+        pattern->program[jump].x = (unsigned short)pattern->program_length;
+        return 0;
+    case RNODE_STAR:
+        // L1: split L2, L3; L2: e; jmp L1; L3:
+        if ((split = regexEmit(pattern, capacity, REGEX_SPLIT, 0, 0, 0)) < 0)
+        {
+            return -1;
+        }
+        pattern->program[split].x = (unsigned short)pattern->program_length;
+        if (regexCompileNode(pattern, capacity, nodes, node->left) < 0 || regexEmit(pattern, capacity, REGEX_JMP, 0, split, 0) < 0)
+        {
+            return -1;
+        }
+        pattern->program[split].y = (unsigned short)pattern->program_length;
+        return 0;
+    case RNODE_PLUS:
+        // L1: e; split L1, L2; L2:
+        jump = pattern->program_length;
+        if (regexCompileNode(pattern, capacity, nodes, node->left) < 0 || (split = regexEmit(pattern, capacity, REGEX_SPLIT, 0, jump, 0)) < 0)
+        {
+            return -1;
+        }
+        pattern->program[split].y = (unsigned short)pattern->program_length;
+        return 0;
+    case RNODE_QUEST:
+        // split L1, L2; L1: e; L2:
+        if ((split = regexEmit(pattern, capacity, REGEX_SPLIT, 0, 0, 0)) < 0)
+        {
+            return -1;
+        }
+        pattern->program[split].x = (unsigned short)pattern->program_length;
+        if (regexCompileNode(pattern, capacity, nodes, node->left) < 0)
+        {
+            return -1;
+        }
+        pattern->program[split].y = (unsigned short)pattern->program_length;
+        return 0;
+    }
+    return -1;
+}
 
-            int attempts = currentUser->login_attempts;
+// Lists the leaves of a concatenation in order
+static void patternFlatten(const struct RegexNode *nodes, int index, int *items, int *count)
+{
+    if (nodes[index].type == RNODE_CAT)
+    {
+        patternFlatten(nodes, nodes[index].left, items, count);
+        patternFlatten(nodes, nodes[index].right, items, count);
+    }
+    else
+    {
+        items[(*count)++] = index;
+    }
+}
 
-            if (attempts % 3 == 0)
+// The longest run of characters that every match must contain in sequence
+static void patternRequiredLiteral(struct NamePattern *pattern, const struct RegexNode *nodes, int root, int nodeCount)
+{
+    int *items = malloc(sizeof(int) * nodeCount);
+    int count = 0;
+    char run[MAX_FILE_NAME_LENGTH];
+    size_t runLength = 0;
+
+    pattern->literal_length = 0;
+    if (items == NULL)
+    {
+        return;
+    }
+    patternFlatten(nodes, root, items, &count);
+
+    for (int i = 0; i <= count; ++i)
+    {
+        const struct RegexNode *node = i < count ? &nodes[items[i]] : NULL;
+        int keepsRun = 0;
+
+        if (node != NULL && runLength + 1 < sizeof(run))
+        {
+            if (node->type == RNODE_CHAR)
             {
-                int penaltyDelay = (attempts / 3) * BASE_DELAY_SECONDS;
-                currentUser->delayParams.delayedUsers[currentUser->delayParams.delayedUsersCount].penaltyDelaySeconds = penaltyDelay;
-                startTimerForUser(&(currentUser->delayParams.delayedUsers[currentUser->delayParams.delayedUsersCount].timer), penaltyDelay);
-                strcpy(currentUser->delayParams.delayedUsers[currentUser->delayParams.delayedUsersCount].username, username);
-                currentUser->delayParams.delayedUsersCount++;
-                printf("Too many failed login attempts for user '%s'. Retry after %d seconds.\n", username, penaltyDelay);
+                run[runLength++] = (char)node->c;
+                keepsRun = 1;
             }
-            else
+            else if (node->type == RNODE_PLUS && nodes[node->left].type == RNODE_CHAR)
+            {
+                // One copy is required, but the run cannot continue past the repetition
+                run[runLength++] = (char)nodes[node->left].c;
+            }
+            else if (node->type == RNODE_BOL || node->type == RNODE_EOL || node->type == RNODE_EMPTY)
+            {
+                keepsRun = 1;
+            }
+        }
+
+        if (!keepsRun)
+        {
+            if (runLength > pattern->literal_length)
             {
-                printf("Login failed. Invalid username or password. Attempt %d.\n", attempts);
+                memcpy(pattern->literal, run, runLength);
+                pattern->literal_length = runLength;
             }
+            runLength = 0;
         }
     }
-    else
+    free(items);
+}
+
+int compileNamePattern(struct NamePattern *pattern, const char *source, enum PatternKind kind)
+{
+    memset(pattern, 0, sizeof(struct NamePattern));
+    pattern->kind = kind;
+
+    if (strlen(source) >= MAX_FILE_NAME_LENGTH)
     {
-        printf("Login failed. Invalid username.\n");
+        return -1;
     }
 
-    struct User emptyUser = {"", "", LOW, 0};
-    return emptyUser;
-}
+    pattern->source = strdup(source);
+    if (pattern->source == NULL)
+    {
+        return -1;
+    }
 
-void resetPassword(struct FileSystem *fs, const char *username)
-{
-    if (fs == NULL || username == NULL || isWhitespaceString(username))
+    struct PatternParser parser = {source, NULL, 0, 0, pattern, 0};
+    int root = kind == PATTERN_GLOB ? globParse(&parser) : regexParseAlternation(&parser);
+    if (*parser.p != '\0')
     {
-        printf("Invalid parameters provided for password reset.\n");
-        return;
+        parser.error = 1; // Unbalanced ')'
     }
 
-    if (strlen(username) >= MAX_USERNAME_LENGTH)
+    int capacity = 0;
+    if (parser.error || root < 0 || regexCompileNode(pattern, &capacity, parser.nodes, root) < 0 ||
+        regexEmit(pattern, &capacity, REGEX_MATCH, 0, 0, 0) < 0)
     {
-        printf("Username length exceeds maximum limit.\n");
-        return;
+        free(parser.nodes);
+        freeNamePattern(pattern);
+        return -1;
     }
 
-    struct User *currentUser = NULL;
+    patternRequiredLiteral(pattern, parser.nodes, root, parser.count);
+    free(parser.nodes);
+    return 0;
+}
 
-    for (int i = 0; i < fs->user_count; ++i)
+// Follows jumps, splits and anchors from 'pc' and adds the character-consuming states reached
+static void regexAddThread(const struct NamePattern *pattern, int *list, int *count, unsigned int *marks, unsigned int mark,
+                           int pc, size_t position, size_t length)
+{
+    int stack[2 * REGEX_MAX_PROGRAM + 1];
+    int top = 0;
+
+    stack[top++] = pc;
+    while (top > 0)
     {
-        if (strcmp(username, fs->users[i].username) == 0)
+        pc = stack[--top];
+        if (marks[pc] == mark)
         {
-            currentUser = &fs->users[i];
+            continue;
+        }
+        marks[pc] = mark;
+
+        const struct RegexInstruction *instruction = &pattern->program[pc];
+        switch (instruction->op)
+        {
+        case REGEX_JMP:
+            stack[top++] = instruction->x;
+            break;
+        case REGEX_SPLIT:
+            stack[top++] = instruction->y;
+            stack[top++] = instruction->x;
+            break;
+        case REGEX_BOL:
+            if (position == 0)
+            {
+                stack[top++] = pc + 1;
+            }
+            break;
+        case REGEX_EOL:
+            if (position == length)
+            {
+                stack[top++] = pc + 1;
+            }
+            break;
+        default:
+            list[(*count)++] = pc;
             break;
         }
     }
+}
 
-    if (currentUser != NULL)
+// Runs the program over the name, all threads in lockstep, so time stays linear in the name length
+int matchNamePattern(const struct NamePattern *pattern, const char *name)
+{
+    int lists[2][REGEX_MAX_PROGRAM];
+    int counts[2] = {0, 0};
+    unsigned int marks[REGEX_MAX_PROGRAM] = {0};
+    unsigned int mark = 1;
+    size_t length = strlen(name);
+    int current = 0;
+
+    regexAddThread(pattern, lists[current], &counts[current], marks, mark, 0, 0, length);
+
+    for (size_t position = 0;; ++position)
     {
-        for (int i = 0; i < currentUser->delayParams.delayedUsersCount; ++i)
+        for (int i = 0; i < counts[current]; ++i)
         {
-            if (isUserTimerExpired(&(currentUser->delayParams.delayedUsers[i].timer)))
+            if (pattern->program[lists[current][i]].op == REGEX_MATCH)
             {
-                currentUser->delayParams.delayedUsers[i].penaltyDelaySeconds = 0;
+                return 1;
             }
         }
-
-        int totalDelay = 0;
-        for (int i = 0; i < currentUser->delayParams.delayedUsersCount; ++i)
+        if (position == length)
         {
-            totalDelay += currentUser->delayParams.delayedUsers[i].penaltyDelaySeconds;
+            return 0;
         }
 
-        if (totalDelay > 0)
-        {
-            printf("Too many failed password reset attempts. Retry after %d seconds.\n", totalDelay);
-            struct User emptyUser = {"", "", LOW, 0};
-            return;
-        }
+        unsigned char c = (unsigned char)name[position];
+        int next = 1 - current;
+        counts[next] = 0;
+        mark++;
 
-        printf("Enter old password: ");
-        char oldPassword[MAX_PASSWORD_LENGTH];
-        int index = 0;
-        char ch;
-        while ((ch = _getch()) != '\r' && index < MAX_PASSWORD_LENGTH - 1)
+        for (int i = 0; i < counts[current]; ++i)
         {
-            if (ch == '\b' && index > 0)
-            {
-                printf("\b \b");
-                index--;
-            }
-            else if (ch != '\b')
+            int pc = lists[current][i];
+            const struct RegexInstruction *instruction = &pattern->program[pc];
+            int advances = (instruction->op == REGEX_CHAR && instruction->c == c) ||
+                           instruction->op == REGEX_ANY ||
+                           (instruction->op == REGEX_CLASS && (pattern->classes[instruction->x][c >> 3] & (1u << (c & 7))));
+            if (advances)
             {
-                printf("*");
-                oldPassword[index++] = ch;
+                regexAddThread(pattern, lists[next], &counts[next], marks, mark, pc + 1, position + 1, length);
             }
         }
-        oldPassword[index] = '\0';
-        printf("\n");
 
-        if (strcmp(oldPassword, currentUser->password) != 0)
+        // A match may start at any position
+        regexAddThread(pattern, lists[next], &counts[next], marks, mark, 0, position + 1, length);
+        current = next;
+    }
+}
+
+void freeNamePattern(struct NamePattern *pattern)
+{
+    free(pattern->source);
+    free(pattern->program);
+    free(pattern->classes);
+    pattern->source = NULL;
+    pattern->program = NULL;
+    pattern->classes = NULL;
+    pattern->program_length = 0;
+    pattern->class_count = 0;
+}
+
+struct PatternMatch
+{
+    char *path;
+    const char *name;
+};
+
+static int comparePatternMatches(const void *a, const void *b)
+{
+    const struct PatternMatch *left = a;
+    const struct PatternMatch *right = b;
+
+    int order = strcmp(left->path, right->path);
+    return order != 0 ? order : strcmp(left->name, right->name);
+}
+
+// Adds every file carrying a matched name that lies under 'rootId'
+static int collectPatternMatches(const struct FileSystem *fs, const struct NamePosting *posting, uint32_t rootId,
+                                 struct PatternMatch **matches, size_t *count, size_t *capacity)
+{
+    for (uint32_t i = 0; i < posting->count; ++i)
+    {
+        uint32_t parentId = fs->inodes.parents[posting->ids[i]];
+        if (!isInSubtree(fs, parentId, rootId))
         {
-            currentUser->login_attempts++;
+            continue;
+        }
 
-            int attempts = currentUser->login_attempts;
-            if (attempts % 3 == 0)
-            {
-                int penaltyDelay = (attempts / 3) * BASE_DELAY_SECONDS;
-                currentUser->delayParams.delayedUsers[currentUser->delayParams.delayedUsersCount].penaltyDelaySeconds = penaltyDelay;
-                startTimerForUser(&(currentUser->delayParams.delayedUsers[currentUser->delayParams.delayedUsersCount].timer), penaltyDelay);
-                strcpy(currentUser->delayParams.delayedUsers[currentUser->delayParams.delayedUsersCount].username, username);
-                currentUser->delayParams.delayedUsersCount++;
-                printf("Too many failed password reset attempts. Retry after %d seconds.\n", penaltyDelay);
-            }
-            else
+        if (*count == *capacity)
+        {
+            size_t newCapacity = *capacity > 0 ? *capacity * 2 : 64;
+            struct PatternMatch *grown = realloc(*matches, sizeof(struct PatternMatch) * newCapacity);
+            if (grown == NULL)
             {
-                printf("Password reset failed. Attempt %d.\n", attempts);
+                return -1;
             }
-            return;
+            *matches = grown;
+            *capacity = newCapacity;
         }
 
-        printf("Enter new password: ");
-        char newPassword[MAX_PASSWORD_LENGTH];
-        index = 0;
-        while ((ch = _getch()) != '\r' && index < MAX_PASSWORD_LENGTH - 1)
+        size_t length = buildDirectoryPath(fs, parentId, NULL, 0);
+        char *path = malloc(length + 1);
+        if (path == NULL)
         {
-            if (ch == '\b' && index > 0)
-            {
-                printf("\b \b");
-                index--;
-            }
-            else if (ch != '\b')
-            {
-                printf("*");
-                newPassword[index++] = ch;
-            }
+            return -1;
         }
-        newPassword[index] = '\0';
-        printf("\n");
+        buildDirectoryPath(fs, parentId, path, length + 1);
 
-        printf("Enter new password again for verification: ");
-        char newPasswordVerify[MAX_PASSWORD_LENGTH];
-        index = 0;
-        while ((ch = _getch()) != '\r' && index < MAX_PASSWORD_LENGTH - 1)
+        (*matches)[*count].path = path;
+        (*matches)[*count].name = posting->name;
+        (*count)++;
+    }
+    return 0;
+}
+
+// Matches the pattern against names rather than files: each distinct name is tested once, and
+// names are found by scanning the packed name heap for the pattern's required literal.
+void searchFilesByPattern(struct FileSystem *fs, const char *path, const char *source, enum PatternKind kind)
+{
+    if (fs == NULL || path == NULL || source == NULL || isWhitespaceString(path) || isWhitespaceString(source))
+    {
+        printf("Invalid parameters provided for file search.\n");
+        return;
+    }
+
+    if (strlen(path) >= MAX_PATH_LENGTH)
+    {
+        printf("Path length exceeds maximum limit.\n");
+        return;
+    }
+
+    struct Directory *currentDir = goTo(fs, path);
+    if (currentDir == NULL)
+    {
+        printf("Invalid parameters provided for file search.\n");
+        return;
+    }
+
+    struct NamePattern pattern;
+    if (compileNamePattern(&pattern, source, kind) != 0)
+    {
+        printf("Invalid %s pattern: %s\n", kind == PATTERN_GLOB ? "glob" : "regex", source);
+        return;
+    }
+
+    double start = getMilliseconds();
+    struct PatternMatch *matches = NULL;
+    size_t matchCount = 0;
+    size_t matchCapacity = 0;
+    size_t candidates = 0;
+    size_t scanned = 0;
+    int failed = 0;
+
+    if (pattern.literal_length > 0)
+    {
+        const struct StringHeap *heap = &fs->names;
+        scanned = heap->name_count;
+
+        for (int b = 0; b < heap->block_count && !failed; ++b)
         {
-            if (ch == '\b' && index > 0)
+            // Blocks are zero-filled, so the unused tail of a full block holds no names
+            const char *block = heap->blocks[b];
+            const char *end = block + (b == heap->block_count - 1 ? heap->block_used : STRING_HEAP_BLOCK_SIZE);
+            const char *cursor = block;
+            const char *hit;
+
+            while (!failed && (hit = findLiteral(cursor, (size_t)(end - cursor), pattern.literal, pattern.literal_length)) != NULL)
             {
-                printf("\b \b");
-                index--;
+                const char *name = hit;
+                while (name > block && name[-1] != '\0')
+                {
+                    name--;
+                }
+                candidates++;
+
+                const struct NamePosting *posting = nameIndexLookup(&fs->name_index, name);
+                if (posting != NULL && matchNamePattern(&pattern, name))
+                {
+                    failed = collectPatternMatches(fs, posting, currentDir->id, &matches, &matchCount, &matchCapacity) != 0;
+                }
+                cursor = name + strlen(name) + 1;
             }
-            else if (ch != '\b')
+        }
+    }
+    else
+    {
+        // Nothing literal to look for, so test every file name the index knows
+        for (size_t i = 0; i < fs->name_index.slot_count && !failed; ++i)
+        {
+            const struct NamePosting *posting = &fs->name_index.slots[i];
+            if (posting->name != NULL && posting->count > 0)
             {
-                printf("*");
-                newPasswordVerify[index++] = ch;
+                scanned++;
+                candidates++;
+                if (matchNamePattern(&pattern, posting->name))
+                {
+                    failed = collectPatternMatches(fs, posting, currentDir->id, &matches, &matchCount, &matchCapacity) != 0;
+                }
             }
         }
-        newPasswordVerify[index] = '\0';
-        printf("\n");
+    }
 
-        if (strcmp(newPassword, newPasswordVerify) != 0)
+    double elapsed = getMilliseconds() - start;
+
+    if (failed)
+    {
+        printf("Memory allocation failed for file search.\n");
+    }
+
+    qsort(matches, matchCount, sizeof(struct PatternMatch), comparePatternMatches);
+    for (size_t i = 0; i < matchCount; ++i)
+    {
+        if (!failed)
         {
-            printf("Passwords do not match. Password reset failed.\n");
-            return;
+            printf("File '%s' found at path: %s\n", matches[i].name, matches[i].path);
         }
+        free(matches[i].path);
+    }
+    free(matches);
 
-        strncpy(currentUser->password, newPassword, MAX_PASSWORD_LENGTH - 1);
-        printf("Password reset successfully for user %s.\n", username);
+    if (!failed)
+    {
+        if (matchCount == 0)
+        {
+            printf("No files matching '%s' found in path: %s\n", source, path);
+        }
+        printf("%zu files matched; %zu names scanned, %zu candidates after the literal prefilter, in %.3f ms.\n",
+               matchCount, scanned, candidates, elapsed);
+    }
 
-        if (strcmp(fs->current_user.username, username) == 0)
+    freeNamePattern(&pattern);
+}
+
+// Paths with '.' components depend on the current directory and are never cached
+int pathHasDotComponent(const char *path)
+{
+    const char *segment = path;
+    while (*segment != '\0')
+    {
+        if (segment[0] == '.' && (segment[1] == '/' || segment[1] == '\0'))
         {
-            strncpy(fs->current_user.password, newPassword, MAX_PASSWORD_LENGTH - 1);
+            return 1;
         }
 
-        currentUser->login_attempts = 0;
+        const char *slash = strchr(segment, '/');
+        if (slash == NULL)
+        {
+            break;
+        }
+        segment = slash + 1;
     }
-    else
+    return 0;
+}
+
+struct Directory *dentryCacheLookup(struct DentryCache *cache, const char *path)
+{
+    if (cache->entries == NULL)
     {
-        printf("User not found.\n");
+        return NULL;
+    }
+
+    unsigned int hash = hashName(path);
+    struct DentryCacheEntry *entry = &cache->entries[hash & (DENTRY_CACHE_SIZE - 1)];
+
+    if (entry->generation == cache->generation && entry->hash == hash && strcmp(entry->path, path) == 0)
+    {
+        cache->hits++;
+        return entry->dir;
     }
+
+    cache->misses++;
+    return NULL;
 }
 
-void initUser(struct User *user)
+void dentryCacheInsert(struct DentryCache *cache, const char *path, struct Directory *dir)
 {
-    if (user != NULL)
+    if (cache->entries == NULL)
     {
-        memset(user->username, 0, MAX_USERNAME_LENGTH);
-        memset(user->password, 0, MAX_PASSWORD_LENGTH);
-        user->access_level = LOW;
-        user->login_attempts = 0;
+        return;
+    }
 
-        user->delayParams.delayedUsersCount = 0; // Reset delayed users count
-        for (int i = 0; i < MAX_DELAYED_USERS; ++i)
-        {
-            memset(user->delayParams.delayedUsers[i].username, 0, MAX_USERNAME_LENGTH);
-            user->delayParams.delayedUsers[i].penaltyDelaySeconds = 0;
-        }
+    unsigned int hash = hashName(path);
+    struct DentryCacheEntry *entry = &cache->entries[hash & (DENTRY_CACHE_SIZE - 1)];
+
+    char *copy = strdup(path);
+    if (copy == NULL)
+    {
+        return;
     }
+
+    free(entry->path);
+    entry->path = copy;
+    entry->hash = hash;
+    entry->generation = cache->generation;
+    entry->dir = dir;
 }
 
-void initFile(struct File *file)
+void invalidateDentryCache(struct FileSystem *fs)
 {
-    if (file != NULL)
+    // Bumping the generation drops every entry without touching the table
+    fs->dcache.generation++;
+    fs->dcache.invalidations++;
+}
+
+struct Directory *goTo1(struct FileSystem *fs, const char *path)
+{
+    if (fs == NULL || path == NULL || isWhitespaceString(path))
     {
-        memset(file->name, 0, MAX_FILE_NAME_LENGTH);
-        memset(file->path, 0, MAX_PATH_LENGTH);
-        file->hMapFile = NULL;
-        file->fileContent = NULL;
-        file->size = 0;
+        printf("Invalid parameters provided for directory navigation.\n");
+        return NULL;
+    }
+
+    // Check for potential buffer overflow in the path
+    if (strlen(path) >= MAX_PATH_LENGTH)
+    {
+        printf("Path length exceeds maximum limit.\n");
+        return NULL;
+    }
+
+    char *inputPath = strdup(path);
+
+    if (strcmp(inputPath, ".") == 0)
+    {
+        // Stay in the current directory
+        inputPath = getCurrentDirectoryPath(fs);
     }
-}
 
-void initDirectory(struct Directory *dir)
-{
-    if (dir != NULL)
+    struct Directory *currentDir = fs->root;
+    char currentPath[MAX_PATH_LENGTH] = ""; // Track the current path
+
+    // Traversing through directories
+    char *token = strtok(inputPath, "/");
+    int firstdotfound = 0;
+
+    while (token != NULL)
     {
-        memset(dir->name, 0, MAX_FILE_NAME_LENGTH);
-        memset(dir->path, 0, MAX_PATH_LENGTH);
-        for (int i = 0; i < MAX_FILES; ++i)
+        if (strcmp(token, ".") == 0)
         {
-            dir->files[i] = NULL;
+            if (!firstdotfound)
+            {
+                token = getCurrentDirectoryPath(fs);
+                firstdotfound = 1;
+            }
+            else
+            {
+                token = strtok(NULL, "/");
+                continue;
+            }
         }
-        dir->file_count = 0;
 
-        for (int i = 0; i < MAX_SUB_DIRS; ++i)
+        // "~" names the root itself
+        if (currentDir == fs->root && strcmp(token, "~") == 0)
         {
-            dir->subdirectories[i] = NULL;
+            token = strtok(NULL, "/");
+            continue;
         }
-        dir->subdir_count = 0;
-
-        dir->access = LOW;
-    }
-}
 
-void initFileSystem(struct FileSystem *fs)
-{
-    if (fs != NULL)
-    {
-        fs->root = malloc(sizeof(struct Directory));
-        if (fs->root == NULL)
+        // Check for individual directory name length
+        size_t dirNameLength = strlen(token);
+        if (dirNameLength >= MAX_FILE_NAME_LENGTH)
         {
-            printf("Memory allocation failed for the root directory.\n");
-            return;
+            printf("Directory name '%s' length exceeds maximum limit.\n", token);
+            return NULL;
         }
 
-        initDirectory(fs->root);
-
-        strncpy(fs->root->name, "root", MAX_FILE_NAME_LENGTH - 1);
-        fs->root->name[MAX_FILE_NAME_LENGTH - 1] = '\0';
-        strcpy(fs->root->path, "~");
+        int found = 0;
 
-        fs->root->subdirectories[0] = malloc(sizeof(struct Directory));
-        if (fs->root->subdirectories[0] == NULL)
+        struct Directory *nextDir = findSubdirectory(fs, currentDir, token);
+        if (nextDir != NULL)
         {
-            printf("Memory allocation failed for the 'home' directory.\n");
-            free(fs->root);
-            return;
-        }
-
-        initDirectory(fs->root->subdirectories[0]);
-
-        strncpy(fs->root->subdirectories[0]->name, "home", MAX_FILE_NAME_LENGTH - 1);
-        fs->root->subdirectories[0]->name[MAX_FILE_NAME_LENGTH - 1] = '\0';
-        strcpy(fs->root->subdirectories[0]->path, "home");
-
-        fs->root->subdir_count = 1;
-        fs->current_directory = fs->root->subdirectories[0];
+            currentDir = nextDir;
+            found = 1;
 
-        fs->user_count = 0;
-        fs->current_user.access_level = LOW;
-        strcpy(fs->current_user.username, "guest");
+            // Update the current path
+            if (strlen(currentPath) > 0)
+            {
+                strncat(currentPath, "/", sizeof(currentPath) - strlen(currentPath) - 1);
+            }
+            strncat(currentPath, token, sizeof(currentPath) - strlen(currentPath) - 1);
+        }
 
-        for (int i = 0; i < MAX_USERS; ++i)
+        if (!found)
         {
-            initUser(&(fs->users[i]));
+            printf("Directory '%s' not found in path '%s'.\n", token, inputPath);
+            return NULL;
         }
 
-        strcpy(fs->users[fs->user_count].username, "admin");
-        strcpy(fs->users[fs->user_count].password, "YAwC4@mdesdin-1r2#3");
-        fs->users[fs->user_count].access_level = HIGHEST;
-        fs->user_count++;
+        token = strtok(NULL, "/");
     }
-}
 
-int createFileInDir(struct FileSystem *fs, const char *path, const char *name)
-{
-    if (name == NULL || isWhitespaceString(name))
-    {
-        printf("Invalid file name provided.\n");
-        return -1;
-    }
+    fs->current_directory = currentDir;
 
-    if (strlen(name) >= MAX_FILE_NAME_LENGTH)
-    {
-        printf("File name length exceeds maximum limit.\n");
-        return -2;
-    }
+    // Update the path correctly
+    free(inputPath);
+    return fs->current_directory;
+}
 
-    if (path == NULL)
+struct Directory *goTo(struct FileSystem *fs, const char *path)
+{
+    if (fs == NULL || path == NULL || isWhitespaceString(path))
     {
-        printf("Invalid path provided for file creation.\n");
-        return -3;
+        printf("Invalid parameters provided for directory navigation.\n");
+        return NULL;
     }
 
+    // Check for potential buffer overflow in the path
     if (strlen(path) >= MAX_PATH_LENGTH)
     {
         printf("Path length exceeds maximum limit.\n");
-        return -4;
+        return NULL;
     }
 
-    char *inputPath = path;
+    char *currentDirPath = NULL;
+    const char *lookupPath = path;
 
-    if (strcmp(inputPath, ".") == 0)
+    if (strcmp(path, ".") == 0)
     {
         // Stay in the current directory
-        inputPath = getCurrentDirectoryPath(fs);
+        currentDirPath = getCurrentDirectoryPath(fs);
+        lookupPath = currentDirPath;
     }
 
-    struct Directory *parentDir = goTo(fs, inputPath);
-    if (parentDir != NULL)
+    int cacheable = !pathHasDotComponent(lookupPath);
+    if (cacheable)
     {
-        if (parentDir->file_count >= MAX_FILES)
+        struct Directory *cachedDir = dentryCacheLookup(&fs->dcache, lookupPath);
+        if (cachedDir != NULL)
         {
-            printf("File limit reached in the parent directory. Cannot create more files.\n");
-            return -5;
+            free(currentDirPath);
+            return cachedDir;
         }
+    }
 
-        // Check if the file already exists in the parent directory
-        for (int i = 0; i < parentDir->file_count; ++i)
+    char *inputPath = strdup(lookupPath);
+
+    struct Directory *currentDir = fs->root;
+    char currentPath[MAX_PATH_LENGTH] = ""; // Track the current path
+
+    // Traversing through directories
+    char *token = strtok(inputPath, "/");
+    int firstdotfound = 0;
+
+    while (token != NULL)
+    {
+        if (strcmp(token, ".") == 0)
         {
-            if (strcmp(parentDir->files[i]->name, name) == 0)
+            if (!firstdotfound)
+            {
+                token = getCurrentDirectoryPath(fs);
+                firstdotfound = 1;
+            }
+            else
             {
-                printf("File '%s' already exists in path: %s\n", name, path);
-                return -6;
+                token = strtok(NULL, "/");
+                continue;
             }
         }
 
-        // Create a new file
-        struct File *newFile = malloc(sizeof(struct File));
-        if (newFile == NULL)
+        // "~" names the root itself
+        if (currentDir == fs->root && strcmp(token, "~") == 0)
         {
-            printf("Memory allocation failed for file creation.\n");
-            return -7;
+            token = strtok(NULL, "/");
+            continue;
         }
 
-        initFile(newFile);
-
-        strncpy(newFile->name, name, MAX_FILE_NAME_LENGTH - 1);
-        newFile->name[MAX_FILE_NAME_LENGTH - 1] = '\0'; // Ensure null-terminated string
-
-        // Constructing the new file's path correctly
-        char newPath[MAX_PATH_LENGTH];
-        snprintf(newPath, MAX_PATH_LENGTH, "%s", parentDir->path);
-
-        strncpy(newFile->path, newPath, MAX_PATH_LENGTH - 1);
-        newFile->path[MAX_PATH_LENGTH - 1] = '\0'; // Ensure null-terminated string
+        // Check for individual directory name length
+        size_t dirNameLength = strlen(token);
+        if (dirNameLength >= MAX_FILE_NAME_LENGTH)
+        {
+            printf("Directory name '%s' length exceeds maximum limit.\n", token);
+            free(inputPath);
+            free(currentDirPath);
+            return NULL;
+        }
 
-        int insertIdx = 0;
+        int found = 0;
 
-        // Find the correct position to insert the new file based on alphabetical order
-        while (insertIdx < parentDir->file_count && strcmp(newFile->name, parentDir->files[insertIdx]->name) > 0)
+        struct Directory *nextDir = findSubdirectory(fs, currentDir, token);
+        if (nextDir != NULL)
         {
-            insertIdx++;
+            currentDir = nextDir;
+            found = 1;
+
+            // Update the current path
+            if (strlen(currentPath) > 0)
+            {
+                strncat(currentPath, "/", sizeof(currentPath) - strlen(currentPath) - 1);
+            }
+            strncat(currentPath, token, sizeof(currentPath) - strlen(currentPath) - 1);
         }
 
-        // Shift files to make space for the new file
-        for (int i = parentDir->file_count; i > insertIdx; --i)
+        if (!found)
         {
-            parentDir->files[i] = parentDir->files[i - 1];
+            printf("Directory '%s' not found in path '%s'.\n", token, lookupPath);
+            free(inputPath);
+            free(currentDirPath);
+            return NULL;
         }
 
-        // Insert the new file at the appropriate position
-        parentDir->files[insertIdx] = newFile;
-        parentDir->file_count++;
-
-        printf("File '%s' created at path: %s\n", name, newFile->path);
-
-        return 0; // Success
-    }
-    else
-    {
-        printf("Parent directory not found at path: %s\n", path);
-        return -8;
+        token = strtok(NULL, "/");
     }
-}
 
-void createDirectory(struct FileSystem *fs, const char *path, const char *name)
-{
-    if (name == NULL || isWhitespaceString(name))
+    if (cacheable)
     {
-        printf("Invalid directory name provided.\n");
-        return;
+        dentryCacheInsert(&fs->dcache, lookupPath, currentDir);
     }
 
-    if (strlen(name) >= MAX_FILE_NAME_LENGTH)
-    {
-        printf("Directory name length exceeds maximum limit.\n");
-        return;
-    }
+    free(inputPath);
+    free(currentDirPath);
+    return currentDir;
+}
 
-    if (path == NULL)
+void displayCurrentDirectory(struct FileSystem *fs, const char *path)
+{
+    if (fs == NULL || path == NULL)
     {
-        printf("Invalid path provided for directory creation.\n");
+        printf("Invalid parameters provided for directory display.\n");
         return;
     }
 
+    // Check for potential buffer overflow in the path
     if (strlen(path) >= MAX_PATH_LENGTH)
     {
         printf("Path length exceeds maximum limit.\n");
@@ -590,95 +7112,73 @@ void createDirectory(struct FileSystem *fs, const char *path, const char *name)
 
     if (strcmp(inputPath, ".") == 0)
     {
-        // Stay in the current directory
         inputPath = getCurrentDirectoryPath(fs);
     }
 
-    struct Directory *parentDir = goTo(fs, inputPath);
-    if (parentDir != NULL)
+    struct Directory *currentDir = goTo(fs, inputPath);
+
+    if (currentDir != NULL)
     {
-        if (parentDir->subdir_count >= MAX_SUB_DIRS)
-        {
-            printf("Subdirectory limit reached in the parent directory. Cannot create more subdirectories.\n");
-            return;
-        }
+        printf("Current Directory: %s\n", nodeName(fs, currentDir->id));
+        char dirPath[MAX_PATH_LENGTH];
+        buildDirectoryPath(fs, currentDir->id, dirPath, sizeof(dirPath));
+        printf("Path: %s\n", dirPath);
+        printf("Files and Directories in the first level:\n");
 
-        // Check if the directory already exists in the parent directory
-        for (int i = 0; i < parentDir->subdir_count; ++i)
+        // Display files in the directory if they exist
+        printf("Files:\n");
+        if (currentDir->files.count > 0)
         {
-            if (strcmp(parentDir->subdirectories[i]->name, name) == 0)
+            childIndexSort(&fs->inodes, &currentDir->files);
+            for (int i = 0; i < currentDir->files.count; ++i)
             {
-                printf("Directory '%s' already exists in path: %s\n", name, path);
-                return;
+                printf("File %d: %s\n", i + 1, nodeName(fs, currentDir->files.ids[i]));
             }
         }
-
-        // Create a new directory
-        struct Directory *newDir = malloc(sizeof(struct Directory));
-        if (newDir == NULL)
+        else
         {
-            printf("Memory allocation failed for directory creation.\n");
-            return;
+            printf("No files in '%s'.\n", dirPath);
         }
 
-        initDirectory(newDir);
-
-        strncpy(newDir->name, name, MAX_FILE_NAME_LENGTH - 1);
-        newDir->name[MAX_FILE_NAME_LENGTH - 1] = '\0'; // Ensure null-terminated string
-
-        // Constructing the new directory's path correctly
-        char newPath[MAX_PATH_LENGTH];
-        snprintf(newPath, MAX_PATH_LENGTH, "%s/%s", parentDir->path, name);
-
-        strncpy(newDir->path, newPath, MAX_PATH_LENGTH - 1);
-        newDir->path[MAX_PATH_LENGTH - 1] = '\0'; // Ensure null-terminated string
-
-        int insertIdx = 0;
-
-        // Find the correct position to insert the new directory based on alphabetical order
-        while (insertIdx < parentDir->subdir_count && strcmp(newDir->name, parentDir->subdirectories[insertIdx]->name) > 0)
+        // Display directories in the directory if they exist
+        printf("Directories:\n");
+        if (currentDir->subdirectories.count > 0)
         {
-            insertIdx++;
+            childIndexSort(&fs->inodes, &currentDir->subdirectories);
+            for (int i = 0; i < currentDir->subdirectories.count; ++i)
+            {
+                printf("Directory %d: %s\n", i + 1, nodeName(fs, currentDir->subdirectories.ids[i]));
+            }
         }
-
-        // Shift directories to make space for the new directory
-        for (int i = parentDir->subdir_count; i > insertIdx; --i)
+        else
         {
-            parentDir->subdirectories[i] = parentDir->subdirectories[i - 1];
+            printf("No directories in '%s'.\n", dirPath);
         }
-
-        // Insert the new directory at the appropriate position
-        parentDir->subdirectories[insertIdx] = newDir;
-        parentDir->subdir_count++;
-
-        printf("Directory '%s' created at path: %s\n", name, newDir->path);
     }
     else
     {
-        printf("Parent directory not found at path: %s\n", path);
+        printf("Invalid directory or path provided for display.\n");
     }
 }
 
-void writeFile(struct FileSystem *fs, const char *filePath, const char *fileName, const char *content)
+void displayFileInDirectory(struct FileSystem *fs, const char *path, const char *fileName)
 {
-    if (fs == NULL || filePath == NULL || fileName == NULL || content == NULL ||
-        isWhitespaceString(filePath) || isWhitespaceString(fileName))
+    if (fs == NULL || path == NULL || fileName == NULL || isWhitespaceString(fileName))
     {
-        printf("Invalid parameters provided for file writing.\n");
+        printf("Invalid parameters provided for file display.\n");
         return;
     }
 
-    size_t pathLength = strlen(filePath);
+    // Check the length of fileName and path
     size_t fileNameLength = strlen(fileName);
-
-    // Check for maximum path and file name lengths
-    if (pathLength >= MAX_PATH_LENGTH || fileNameLength >= MAX_FILE_NAME_LENGTH)
+    size_t pathLength = strlen(path);
+    if (fileNameLength == 0 || fileNameLength >= MAX_FILE_NAME_LENGTH || pathLength >= MAX_PATH_LENGTH)
     {
-        printf("Path or file name length exceeds maximum limit.\n");
+        printf("Invalid file name or path length.\n");
         return;
     }
 
-    char *inputPath = filePath;
+    char *inputPath = path;
 
     if (strcmp(inputPath, ".") == 0)
     {
@@ -686,1066 +7186,1434 @@ void writeFile(struct FileSystem *fs, const char *filePath, const char *fileName
         inputPath = getCurrentDirectoryPath(fs);
     }
 
-    struct Directory *dir = goTo(fs, inputPath);
+    struct Directory *currentDir = goTo(fs, inputPath);
 
-    if (dir != NULL)
+    if (currentDir != NULL)
     {
-        // Check if the file already exists in the directory using binary search
-        int low = 0;
-        int high = dir->file_count - 1;
-        int fileExists = 0;
-
-        while (low <= high)
+        int found = 0;
+        struct File *file = findFile(fs, currentDir, fileName);
+        if (file != NULL)
         {
-            int mid = low + (high - low) / 2;
-            int compare = strcmp(dir->files[mid]->name, fileName);
-
-            if (compare == 0)
-            {
-                struct File *existingFile = dir->files[mid];
-
-                // Update file content and size
-                strcpy((char *)existingFile->fileContent, content);
-                existingFile->size = strlen(content);
-                printf("Content written to file '%s'.\n", fileName);
-                fileExists = 1;
-                break;
-            }
-            else if (compare < 0)
+            printf("File Name: %s\n", fileName);
+            char filePath[MAX_PATH_LENGTH];
+            buildDirectoryPath(fs, currentDir->id, filePath, sizeof(filePath));
+            printf("File Path: %s\n", filePath);
+            printf("File Size: %llu bytes\n", (unsigned long long)file->size);
+
+            // Check if content exists before displaying
+            if (file->content != NULL || file->small != NULL)
             {
-                low = mid + 1;
+                printf("File Content:\n");
+                printFileContent(file, 0, file->size, stdout);
+                printf("\n");
             }
             else
             {
-                high = mid - 1;
+                printf("File Content: Not available\n");
             }
+
+            found = 1;
         }
 
-        // If the file doesn't exist, create it
-        if (!fileExists)
+        if (!found)
         {
-            createFileInDir(fs, filePath, fileName); // Create the file
-
-            // Find the newly created file after binary search
-            low = 0;
-            high = dir->file_count - 1;
-
-            while (low <= high)
-            {
-                int mid = low + (high - low) / 2;
-                int compare = strcmp(dir->files[mid]->name, fileName);
-
-                if (compare == 0)
-                {
-                    struct File *newFile = dir->files[mid];
-
-                    // Update file content and size
-                    strcpy((char *)newFile->fileContent, content);
-                    newFile->size = strlen(content);
-                    printf("File '%s' created and content written.\n", fileName);
-                    break;
-                }
-                else if (compare < 0)
-                {
-                    low = mid + 1;
-                }
-                else
-                {
-                    high = mid - 1;
-                }
-            }
+            printf("File '%s' not found in the directory '%s'.\n", fileName, path);
         }
     }
     else
     {
-        printf("Directory not found at path: %s\n", filePath);
+        printf("Directory not found or invalid path provided.\n");
     }
 }
 
-void readFile(struct FileSystem *fs, const char *filePath, const char *fileName)
+void changeDirectoryAccessLevel(struct FileSystem *fs, const char *dirPath, enum AuthorityLevel newAccessLevel)
 {
-    if (fs == NULL || filePath == NULL || fileName == NULL || isWhitespaceString(filePath) || isWhitespaceString(fileName))
+    if (fs == NULL || dirPath == NULL)
     {
-        printf("Invalid parameters provided for file reading.\n");
+        printf("Invalid parameter detected.\n");
         return;
     }
 
-    size_t pathLength = strlen(filePath);
-    size_t fileNameLength = strlen(fileName);
+    // Check for potential buffer overflow in the directory path
+    if (strlen(dirPath) >= MAX_PATH_LENGTH)
+    {
+        printf("Directory path length exceeds maximum limit.\n");
+        return;
+    }
 
-    // Check for maximum path and file name lengths
-    if (pathLength >= MAX_PATH_LENGTH || fileNameLength >= MAX_FILE_NAME_LENGTH)
+    // Check if the newAccessLevel is a valid AuthorityLevel value
+    if (newAccessLevel < LOW || newAccessLevel > HIGHEST)
     {
-        printf("Path or file name length exceeds maximum limit.\n");
+        printf("Invalid AuthorityLevel specified.\n");
         return;
     }
 
-    char *inputPath = filePath;
+    char *inputPath = dirPath;
 
     if (strcmp(inputPath, ".") == 0)
     {
-        // Stay in the current directory
         inputPath = getCurrentDirectoryPath(fs);
     }
 
-    struct Directory *dir = goTo(fs, inputPath);
-
-    if (dir != NULL)
+    struct Directory *targetDir = goTo(fs, inputPath);
+    if (targetDir != NULL && targetDir->subdirectories.count > 0)
     {
-        if (dir->file_count <= 0)
-        {
-            printf("No files found in directory '%s'.\n", filePath);
-            return;
-        }
-
-        // Use binary search to find the file
-        int low = 0;
-        int high = dir->file_count - 1;
-
-        while (low <= high)
+        for (int i = 0; i < targetDir->subdirectories.count; ++i)
         {
-            int mid = low + (high - low) / 2;
-            int compare = strcmp(dir->files[mid]->name, fileName);
-
-            if (compare == 0)
-            {
-                printf("Content of file '%s':\n%s\n", fileName, (char *)dir->files[mid]->fileContent);
-                return;
-            }
-            else if (compare < 0)
-            {
-                low = mid + 1;
-            }
-            else
-            {
-                high = mid - 1;
-            }
+            struct Directory *subdir = fs->inodes.nodes[targetDir->subdirectories.ids[i]];
+            subdir->access = newAccessLevel;
         }
-
-        printf("File '%s' not found in directory '%s'.\n", fileName, filePath);
+        printf("Directory access level changed successfully.\n");
     }
     else
     {
-        printf("Directory not found at path: %s\n", filePath);
+        printf("Directory not found or invalid path provided.\n");
     }
 }
 
-void deleteFileAtPath(struct FileSystem *fs, const char *path, const char *fileName)
+// Records a host file for a lazy load without opening it: its size and modification time now,
+// the mapping when it is first read. 'content' is left NULL for an empty file that is not
+// writable. -1 if the host file is not there or memory runs out.
+static int recordHostFile(const char *hostPath, int writable, struct Content **content, uint64_t *size)
 {
-    if (fs == NULL || path == NULL || fileName == NULL || isWhitespaceString(path) || isWhitespaceString(fileName))
+    struct HostMapping recorded = {NULL, 0, 0, writable};
+    *content = NULL;
+    if (statHostFile(hostPath, &recorded.size, &recorded.modified) != 0)
     {
-        printf("Invalid parameters provided for file deletion.\n");
-        return;
+        return -1;
     }
-
-    size_t pathLength = strlen(path);
-    size_t fileNameLength = strlen(fileName);
-
-    // Check for maximum path and file name lengths
-    if (pathLength >= MAX_PATH_LENGTH || fileNameLength >= MAX_FILE_NAME_LENGTH)
+    *size = recorded.size;
+    if (recorded.size == 0 && !writable)
     {
-        printf("Path or file name length exceeds maximum limit.\n");
-        return;
+        return 0;
     }
 
-    char *inputPath = path;
-
-    if (strcmp(inputPath, ".") == 0)
+    *content = mappedContent(&recorded, hostPath);
+    if (*content == NULL)
     {
-        // Stay in the current directory
-        inputPath = getCurrentDirectoryPath(fs);
+        return -1;
     }
+    (*content)->state = recorded.size > 0 ? CONTENT_DEFERRED : CONTENT_READY;
+    return 0;
+}
 
-    struct Directory *dir = goTo(fs, inputPath);
+int loadFileContent(const char *fileName, const char *hostPath, const char *subsystemPath, struct FileSystem *fs, const struct LoadOptions *options)
+{
+    if (fileName == NULL || hostPath == NULL || subsystemPath == NULL || fs == NULL || options == NULL || isWhitespaceString(fileName))
+    {
+        printf("Invalid parameters for loading file content.\n");
+        return -1;
+    }
 
-    if (dir != NULL)
+    struct File *file = getFileInDirectory(fs, subsystemPath, fileName);
+    if (file == NULL)
     {
-        int fileIndex = -1;
+        printf("File '%s' not found in the given subsystem path '%s'.\n", fileName, subsystemPath);
+        return -1;
+    }
 
-        // Find the index of the file to delete using binary search
-        int left = 0, right = dir->file_count - 1;
-        while (left <= right)
+    // A lazy load only records the host file
+    if (options->lazy)
+    {
+        struct Content *content;
+        uint64_t size;
+        if (recordHostFile(hostPath, options->map.writable, &content, &size) != 0)
         {
-            int mid = left + (right - left) / 2;
-            int comparison = strcmp(dir->files[mid]->name, fileName);
-
-            if (comparison == 0)
-            {
-                fileIndex = mid;
-                break;
-            }
-            else if (comparison < 0)
-            {
-                left = mid + 1;
-            }
-            else
-            {
-                right = mid - 1;
-            }
+            printf("Failed to record host file '%s'.\n", hostPath);
+            return -1;
         }
+        releaseFileContent(fs, file);
+        file->content = content;
+        file->size = content != NULL ? size : 0;
+        updateTrigramIndex(fs, file);
+        return 0;
+    }
 
-        if (fileIndex != -1)
-        {
-            // Free file content
-            if (dir->files[fileIndex]->fileContent != NULL)
-            {
-                UnmapViewOfFile(dir->files[fileIndex]->fileContent);
-                CloseHandle(dir->files[fileIndex]->hMapFile);
-            }
+    // A copy into the block store reads the mapping once, front to back
+    struct MapOptions map = options->map;
+    if (!options->keep_mapping && map.hint == ACCESS_NORMAL)
+    {
+        map.hint = ACCESS_SEQUENTIAL;
+    }
 
-            // Free file structure and rearrange the file array
-            free(dir->files[fileIndex]);
-            for (int i = fileIndex; i < dir->file_count - 1; ++i)
-            {
-                dir->files[i] = dir->files[i + 1];
-            }
-            dir->files[dir->file_count - 1] = NULL;
-            dir->file_count--;
+    struct HostMapping mapping;
+    if (mapHostFile(hostPath, &map, &mapping) != 0)
+    {
+        return -1;
+    }
 
-            printf("File '%s' deleted from directory '%s'.\n", fileName, dir->name);
-        }
-        else
+    // Empty files just leave the subsystem file empty, unless later writes are to reach them
+    if (mapping.data == NULL && !mapping.writable)
+    {
+        releaseFileContent(fs, file);
+        updateTrigramIndex(fs, file);
+        return 0;
+    }
+
+    // Small content moves into the file node, whatever was asked, unless the mapping is
+    // writable: then the file is served from it at any size, so every write reaches the host
+    if (mapping.writable || (options->keep_mapping && smallContentClass(mapping.size + 1) == SMALL_CLASS_COUNT))
+    {
+        struct Content *content = mappedContent(&mapping, hostPath);
+        if (content == NULL)
         {
-            printf("File '%s' not found in directory '%s'.\n", fileName, path);
+            printf("Memory allocation failed while loading '%s'.\n", hostPath);
+            unmapHostFile(&mapping);
+            return -1;
         }
+
+        releaseFileContent(fs, file);
+        file->content = content;
+        file->size = mapping.size;
+        updateTrigramIndex(fs, file);
+        return 0;
     }
-    else
+
+    // Chunk the mapped bytes into the block store, where content loaded from several host
+    // paths is kept once, then let the mapping go
+    int result = setFileContent(fs, file, mapping.data, mapping.size);
+    unmapHostFile(&mapping);
+    if (result != 0)
     {
-        printf("Directory not found at path: %s\n", path);
+        printf("Memory allocation failed while loading '%s'.\n", hostPath);
+        return -1;
     }
+
+    updateTrigramIndex(fs, file);
+    return 0;
 }
 
-// Helper function for binary search to find directory index
-int binarySearchDir(struct Directory *dirs[], int l, int r, const char *name)
+// Writes a file's content to a freshly created host file; any thread may call this. Content
+// still served from the host file it was loaded from is copied in the kernel, and 'method'
+// says how the bytes went out.
+static int writeHostFileContent(const struct File *file, PlatformFile hostFile, const char **method)
 {
-    while (l <= r)
+    const struct Content *content = file->content;
+    uint64_t offset = 0;
+    if (file->small == NULL && content != NULL && content->mapped && content->host_path != NULL)
     {
-        int mid = l + (r - l) / 2;
-        int cmp = strcmp(dirs[mid]->name, name);
+        offset = copyHostFile(hostFile, content->host_path, &content->mapping, method);
+    }
 
-        if (cmp == 0)
+    // Anything else goes out a view at a time, with small views such as single blocks
+    // gathered so each write carries up to EXPORT_BUFFER_SIZE bytes
+    uint64_t remaining = file->size - offset;
+    char *buffer = remaining > 0 ? malloc(remaining < EXPORT_BUFFER_SIZE ? (size_t)remaining : EXPORT_BUFFER_SIZE) : NULL;
+    size_t buffered = 0;
+    int result = 0;
+    struct ContentView view;
+    initContentView(&view);
+    while (result == 0 && viewFileContent(file, offset, file->size - offset, &view) == 0 && view.length > 0)
+    {
+        if (buffered > 0 && buffered + view.length > EXPORT_BUFFER_SIZE)
         {
-            return mid;
+            result = writeHostFile(hostFile, buffer, buffered);
+            buffered = 0;
         }
-        else if (cmp < 0)
+        if (buffer == NULL || view.length >= EXPORT_BUFFER_SIZE)
         {
-            l = mid + 1;
+            result = result == 0 ? writeHostFile(hostFile, view.data, view.length) : result;
         }
         else
         {
-            r = mid - 1;
+            memcpy(buffer + buffered, view.data, (size_t)view.length);
+            buffered += (size_t)view.length;
         }
+        offset += view.length;
     }
-    return -1;
+    if (result == 0 && buffered > 0)
+    {
+        result = writeHostFile(hostFile, buffer, buffered);
+    }
+    freeContentView(&view);
+    free(buffer);
+    return result != 0 || offset < file->size ? -1 : 0;
 }
 
-void deleteDirectoryAtPath(struct FileSystem *fs, const char *path)
+// Whether the file is served from the host file at 'hostPath', through a mapping or a lazy
+// record; writing it there would truncate its own source
+static int isHostFileSource(const struct File *file, const char *hostPath)
 {
-    if (fs == NULL || path == NULL || isWhitespaceString(path))
+    const struct Content *content = file->small == NULL ? file->content : NULL;
+    return content != NULL && content->mapped && content->host_path != NULL && sameHostFile(content->host_path, hostPath);
+}
+
+int outFileContent(const char *fileName, const char *subsystemPath, const char *hostPath, struct FileSystem *fs)
+{
+    if (fileName == NULL || hostPath == NULL || subsystemPath == NULL || fs == NULL)
     {
-        printf("Invalid parameters provided. Cannot delete directory.\n");
-        return;
+        printf("Invalid parameters for writing file content.\n");
+        return -1;
     }
 
-    // Check for potential buffer overflow in the path
-    if (strlen(path) >= MAX_PATH_LENGTH)
+    struct File *file = getFileInDirectory(fs, subsystemPath, fileName);
+    if (file == NULL || (file->content == NULL && file->small == NULL))
     {
-        printf("Path length exceeds maximum limit.\n");
-        return;
+        printf("File '%s' not found in the given subsystem path '%s' or no content available.\n", fileName, subsystemPath);
+        return -1;
     }
 
-    char *inputPath = path;
-
-    if (strcmp(inputPath, ".") == 0)
+    // Truncating the host file the content is mapped from would pull the bytes out from under it
+    if (isHostFileSource(file, hostPath))
     {
-        // Stay in the current directory
-        inputPath = getCurrentDirectoryPath(fs);
+        printf("Host file '%s' is the file '%s' is served from; it already holds its content.\n", hostPath, fileName);
+        return 0;
+    }
+    if (!isContentReadable(file))
+    {
+        return -1;
     }
 
-    struct Directory *parentDir = goTo(fs, inputPath);
+    PlatformFile hostFile;
+    if (createHostFile(hostPath, &hostFile) != 0)
+    {
+        printf("Failed to open host file '%s' for writing.\n", hostPath);
+        return -1;
+    }
 
-    if (parentDir != NULL)
+    double start = getMilliseconds();
+    const char *method = "buffered writes";
+    int result = writeHostFileContent(file, hostFile, &method);
+    closeHostFile(hostFile);
+    if (result != 0)
     {
-        int idx = binarySearchDir(parentDir->subdirectories, 0, parentDir->subdir_count - 1, path);
+        printf("Failed to write content to host file '%s'.\n", hostPath);
+        return -1;
+    }
 
-        if (idx != -1)
-        {
-            struct Directory *dirToDelete = parentDir->subdirectories[idx];
+    double milliseconds = getMilliseconds() - start;
+    double seconds = milliseconds / 1000.0;
+    printf("Exported %llu bytes in %.3f ms (%.1f MB/s) using %s.\n", (unsigned long long)file->size, milliseconds,
+           seconds > 0 ? file->size / seconds / (1024.0 * 1024.0) : 0.0, method);
+    return 0;
+}
 
-            if (dirToDelete->file_count > 0)
-            {
-                // Delete files within the directory
-                for (int i = 0; i < dirToDelete->file_count; ++i)
-                {
-                    deleteFileAtPath(fs, dirToDelete->path, dirToDelete->files[i]->name);
-                }
-            }
+// Writes the dirty pages of a file served from a writable mapping back to its host file,
+// adding the bytes flushed to 'flushed'. Returns 1 for such a file, dirty or not, 0 for any
+// other file, and -1 if a flush failed; the ranges that failed stay dirty.
+int syncFileContent(struct File *file, uint64_t *flushed)
+{
+    struct Content *content = file->small == NULL ? file->content : NULL;
+    if (content == NULL || !content->writable)
+    {
+        return 0;
+    }
 
-            if (dirToDelete->subdir_count > 0)
-            {
-                // Delete subdirectories recursively
-                for (int i = 0; i < dirToDelete->subdir_count; ++i)
-                {
-                    deleteDirectoryAtPath(fs, dirToDelete->subdirectories[i]->path);
-                }
-            }
+    int result = 1;
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < content->dirty_count; ++i)
+    {
+        // Pages past a shrunk end are gone from the host file already
+        struct DirtyRange range = content->dirty[i];
+        uint64_t end = range.end < content->mapping.size ? range.end : content->mapping.size;
+        if (range.start >= end)
+        {
+            continue;
+        }
+        if (flushHostMapping(&content->mapping, range.start, end - range.start) != 0)
+        {
+            content->dirty[kept++] = range;
+            result = -1;
+            continue;
+        }
+        *flushed += end - range.start;
+    }
+    content->dirty_count = kept;
+    return result;
+}
 
-            printf("Directory '%s' at path '%s' deleted.\n", dirToDelete->name, dirToDelete->path);
-            free(dirToDelete);
+// sync: flushes the dirty pages of files loaded with a writable mapping to their host files;
+// one file with a name, every file under 'path' without, and every file when 'path' is NULL
+void syncFiles(struct FileSystem *fs, const char *path, const char *fileName)
+{
+    if (fs == NULL || (path != NULL && isWhitespaceString(path)))
+    {
+        printf("Invalid parameters provided for sync.\n");
+        return;
+    }
 
-            // Shift elements after deletion
-            for (int i = idx; i < parentDir->subdir_count - 1; ++i)
-            {
-                parentDir->subdirectories[i] = parentDir->subdirectories[i + 1];
-            }
-            parentDir->subdirectories[parentDir->subdir_count - 1] = NULL;
-            parentDir->subdir_count--;
+    double start = getMilliseconds();
+    size_t synced = 0;
+    size_t failed = 0;
+    uint64_t flushed = 0;
+    if (fileName != NULL)
+    {
+        struct File *file = getFileInDirectory(fs, path, fileName);
+        if (file == NULL)
+        {
+            return;
         }
-        else
+        int result = syncFileContent(file, &flushed);
+        if (result == 0)
         {
-            printf("Directory not found at path: %s\n", path);
+            printf("File '%s' is not loaded with a writable mapping.\n", fileName);
+            return;
         }
+        synced += result > 0;
+        failed += result < 0;
     }
     else
     {
-        printf("Parent directory not found at path: %s\n", path);
+        const char *inputPath = path;
+        if (path != NULL && strcmp(path, ".") == 0)
+        {
+            inputPath = getCurrentDirectoryPath(fs);
+        }
+        struct Directory *dir = path != NULL ? goTo(fs, inputPath) : fs->root;
+        if (dir == NULL)
+        {
+            printf("Directory not found at path: %s\n", path);
+            return;
+        }
+
+        const struct InodeTable *table = &fs->inodes;
+        for (uint32_t id = 0; id < table->count; ++id)
+        {
+            if (table->kinds[id] == INODE_FILE && (dir == fs->root || isInSubtree(fs, id, dir->id)))
+            {
+                int result = syncFileContent(table->nodes[id], &flushed);
+                synced += result > 0;
+                failed += result < 0;
+            }
+        }
+    }
+
+    printf("Synced %zu files with writable mappings: %llu bytes of dirty pages flushed in %.3f ms.\n", synced,
+           (unsigned long long)flushed, getMilliseconds() - start);
+    if (failed > 0)
+    {
+        printf("%zu files could not be flushed and are still dirty.\n", failed);
     }
 }
 
-void moveDirectoryAtPath(struct FileSystem *fs, const char *sourcePath, const char *destinationPath)
+// Whether the host file at 'hostPath', already known to have this file's size, holds the same
+// bytes: compared view by view against a mapping of the host file
+static int hostFileHoldsContent(const struct File *file, const char *hostPath)
 {
-    if (fs == NULL || sourcePath == NULL || destinationPath == NULL ||
-        isWhitespaceString(sourcePath) || isWhitespaceString(destinationPath))
+    struct MapOptions map = {ACCESS_SEQUENTIAL, 0, 0, 0};
+    struct HostMapping mapping;
+    if (file->size == 0 || mapHostFile(hostPath, &map, &mapping) != 0 || mapping.size != file->size)
     {
-        printf("Invalid parameters provided. Cannot move directory.\n");
-        return;
+        return file->size == 0;
     }
 
-    // Check for potential buffer overflow in the paths
-    if (strlen(sourcePath) >= MAX_PATH_LENGTH || strlen(destinationPath) >= MAX_PATH_LENGTH)
+    int same = 1;
+    uint64_t offset = 0;
+    struct ContentView view;
+    initContentView(&view);
+    while (same && viewFileContent(file, offset, file->size - offset, &view) == 0 && view.length > 0)
     {
-        printf("Path length exceeds maximum limit.\n");
-        return;
+        same = memcmp(mapping.data + offset, view.data, (size_t)view.length) == 0;
+        offset += view.length;
     }
+    freeContentView(&view);
+    unmapHostFile(&mapping);
+    return same && offset == file->size;
+}
 
-    char *inputSourcePath = sourcePath;
-    char *inputDestPath = destinationPath;
+// Whether the host file at 'hostPath' already holds exactly this file's content, sizes first
+static int hostFileMatches(const struct File *file, const char *hostPath)
+{
+    uint64_t size;
+    int64_t modified;
+    return statHostFile(hostPath, &size, &modified) == 0 && size == file->size && hostFileHoldsContent(file, hostPath);
+}
 
-    if (strcmp(inputSourcePath, ".") == 0)
+// Exports one file of a recursive out; runs on any thread and only reads the file
+static void exportRunJob(struct ExportJob *job)
+{
+    if (isHostFileSource(job->file, job->host_path) || hostFileMatches(job->file, job->host_path))
     {
-        inputSourcePath = getCurrentDirectoryPath(fs);
+        job->result = 0;
+        return;
     }
 
-    if (strcmp(inputDestPath, ".") == 0)
+    PlatformFile hostFile;
+    if (!isContentReadable(job->file) || createHostFile(job->host_path, &hostFile) != 0)
     {
-        // Stay in the current directory
-        inputDestPath = getCurrentDirectoryPath(fs);
+        job->result = -1;
+        return;
     }
+    preallocateHostFile(hostFile, job->file->size);
 
-    struct Directory *sourceDir = goTo(fs, inputSourcePath);
-    struct Directory *destinationDir = goTo(fs, inputDestPath);
+    const char *method = NULL;
+    job->result = writeHostFileContent(job->file, hostFile, &method) == 0 ? 1 : -1;
+    closeHostFile(hostFile);
+}
 
-    if (sourceDir != NULL && destinationDir != NULL)
+// Sets up one worker of a recursive load or out. A batching worker gets its own queue and an
+// equal share of the in-flight byte limit; -1 if memory runs out.
+static int initHostIoWorker(struct HostIoWorker *worker, void *owner, const struct HostIoSettings *settings, int batched, int workerCount)
+{
+    memset(worker, 0, sizeof(struct HostIoWorker));
+    worker->owner = owner;
+    worker->queue.ring_fd = -1;
+    if (!batched)
     {
-        int index = binarySearchDir(sourceDir->subdirectories, 0, sourceDir->subdir_count - 1, destinationPath);
-
-        if (index != -1)
-        {
-            // Move files to the destination directory
-            for (int i = 0; i < sourceDir->file_count; ++i)
-            {
-                if (destinationDir->file_count >= MAX_FILES)
-                {
-                    printf("Destination directory has reached maximum file count. Cannot move all files.\n");
-                    return;
-                }
-
-                char newPath[MAX_PATH_LENGTH];
-                snprintf(newPath, MAX_PATH_LENGTH, "%s/%s", destinationPath, sourceDir->files[i]->name);
-                snprintf(sourceDir->files[i]->path, MAX_PATH_LENGTH, "%s", newPath);
-                destinationDir->files[destinationDir->file_count++] = sourceDir->files[i];
-                sourceDir->files[i] = NULL;
-            }
-            sourceDir->file_count = 0;
+        return 0;
+    }
 
-            // Move subdirectories to the destination directory
-            for (int i = 0; i < sourceDir->subdir_count; ++i)
-            {
-                if (destinationDir->subdir_count >= MAX_SUB_DIRS)
-                {
-                    printf("Destination directory has reached maximum subdirectory count. Cannot move all subdirectories.\n");
-                    return;
-                }
+    worker->depth = settings->queue_depth;
+    worker->budget = settings->inflight_bytes / (uint64_t)workerCount;
+    if (worker->budget < CHUNK_MAX_SIZE)
+    {
+        worker->budget = CHUNK_MAX_SIZE;
+    }
+    worker->requests = malloc(sizeof(struct HostIoRequest) * 3 * worker->depth);
+    worker->batch = malloc(sizeof(size_t) * worker->depth);
+    worker->slots = malloc(sizeof(size_t) * worker->depth);
+    worker->buffers = malloc(sizeof(void *) * worker->depth);
+    if (worker->requests == NULL || worker->batch == NULL || worker->slots == NULL || worker->buffers == NULL)
+    {
+        free(worker->requests);
+        free(worker->batch);
+        free(worker->slots);
+        free(worker->buffers);
+        return -1;
+    }
+    initHostIoQueue(&worker->queue, worker->depth, 1);
+    return 0;
+}
 
-                char newPath[MAX_PATH_LENGTH];
-                snprintf(newPath, MAX_PATH_LENGTH, "%s/%s", destinationPath, sourceDir->subdirectories[i]->name);
-                snprintf(sourceDir->subdirectories[i]->path, MAX_PATH_LENGTH, "%s", newPath);
-                destinationDir->subdirectories[destinationDir->subdir_count++] = sourceDir->subdirectories[i];
-                sourceDir->subdirectories[i] = NULL;
-            }
-            sourceDir->subdir_count = 0;
+// Adds a worker's request and system call counts to the file system's totals and frees it
+static void freeHostIoWorker(struct FileSystem *fs, struct HostIoWorker *worker)
+{
+    if (worker->requests == NULL)
+    {
+        return;
+    }
+    fs->host_io.system_calls += worker->queue.system_calls;
+    fs->host_io.operations += worker->queue.operations;
+    fs->host_io.uring_missing |= !worker->queue.uring;
+    freeHostIoQueue(&worker->queue);
+    free(worker->requests);
+    free(worker->batch);
+    free(worker->slots);
+    free(worker->buffers);
+}
 
-            printf("Directory '%s' moved to '%s'.\n", sourceDir->name, destinationDir->name);
-        }
-        else
+// Sets up the workers of a recursive load or out, batching when 'batchable' and the io_uring
+// backend is selected and dropping back to unbatched workers if memory runs out; returns
+// whether they batch
+static int initHostIoWorkers(struct FileSystem *fs, struct HostIoWorker *workers, int workerCount, void *owner, int batchable)
+{
+    int batched = batchable && fs->host_io.backend == HOST_IO_URING;
+    for (int i = 0; i < workerCount && batched; ++i)
+    {
+        if (initHostIoWorker(&workers[i], owner, &fs->host_io, 1, workerCount) != 0)
         {
-            printf("Source directory '%s' not found or not a subdirectory of '%s'. Cannot move.\n", sourceDir->name, destinationDir->name);
+            while (i > 0)
+            {
+                freeHostIoWorker(fs, &workers[--i]);
+            }
+            batched = 0;
         }
     }
-    else
+    for (int i = 0; i < workerCount && !batched; ++i)
     {
-        printf("Invalid source or destination directory. Cannot move.\n");
+        initHostIoWorker(&workers[i], owner, &fs->host_io, 0, workerCount);
     }
+    return batched;
 }
 
-void moveFileAtPath(struct FileSystem *fs, const char *sourcePath, const char *destinationPath, const char *fileName)
+// The "N requests in M system calls" part of a batched summary, into 'text'
+static void describeHostIo(const struct HostIoWorker *workers, int workerCount, char *text, size_t size)
 {
-    if (fs == NULL || sourcePath == NULL || destinationPath == NULL || fileName == NULL ||
-        isWhitespaceString(sourcePath) || isWhitespaceString(destinationPath) || isWhitespaceString(fileName))
+    unsigned long operations = 0;
+    unsigned long systemCalls = 0;
+    int uring = 1;
+    for (int i = 0; i < workerCount; ++i)
     {
-        printf("Invalid parameters provided. Cannot move file.\n");
-        return;
+        operations += workers[i].queue.operations;
+        systemCalls += workers[i].queue.system_calls;
+        uring &= workers[i].queue.uring;
     }
+    snprintf(text, size, "%lu host I/O requests in %lu system calls (%s)", operations, systemCalls,
+             uring ? "io_uring" : "blocking");
+}
 
-    // Check for potential buffer overflow in the paths and fileName
-    if (strlen(sourcePath) >= MAX_PATH_LENGTH || strlen(destinationPath) >= MAX_PATH_LENGTH || strlen(fileName) >= MAX_FILE_NAME_LENGTH)
+// Claims up to 'depth' of the remaining jobs into 'batch'; returns how many
+static size_t claimHostIoBatch(volatile long *next, size_t jobCount, size_t *batch, unsigned depth)
+{
+    size_t count = 0;
+    long index;
+    while (count < depth && (index = atomicIncrement(next) - 1) < (long)jobCount)
     {
-        printf("Path or file name length exceeds maximum limit.\n");
-        return;
+        batch[count++] = (size_t)index;
     }
+    return count;
+}
 
-    char *inputSourcePath = sourcePath;
-    char *inputDestPath = destinationPath;
-
-    if (strcmp(inputSourcePath, ".") == 0)
+// Writes a batch of claimed jobs through the worker's queue. The host sizes of every target go
+// out as one round, so only targets of the right size are compared; the opens, the
+// preallocations and writes, and the closes then go out as a round each, over as many files as
+// the worker's buffer budget holds. Host-backed content that can be copied in the kernel, and
+// files bigger than the budget, are written one at a time instead.
+static void exportRunBatch(struct HostExport *export, struct HostIoWorker *worker, size_t count)
+{
+    struct HostIoRequest *requests = worker->requests;
+    for (size_t i = 0; i < count; ++i)
     {
-        inputSourcePath = getCurrentDirectoryPath(fs);
+        memset(&requests[i], 0, sizeof(struct HostIoRequest));
+        requests[i].op = HOST_IO_SIZE;
+        requests[i].path = export->jobs[worker->batch[i]].host_path;
     }
+    runHostIo(&worker->queue, requests, count);
 
-    if (strcmp(inputDestPath, ".") == 0)
+    size_t pending = 0;
+    for (size_t i = 0; i < count; ++i)
     {
-        // Stay in the current directory
-        inputDestPath = getCurrentDirectoryPath(fs);
+        struct ExportJob *job = &export->jobs[worker->batch[i]];
+        const struct Content *content = job->file->content;
+        if (!requests[i].failed && requests[i].length == job->file->size && hostFileHoldsContent(job->file, job->host_path))
+        {
+            job->result = 0;
+        }
+        else if ((job->file->small == NULL && content != NULL && content->mapped && content->host_path != NULL) ||
+                 job->file->size > worker->budget)
+        {
+            exportRunJob(job);
+        }
+        else
+        {
+            worker->batch[pending++] = worker->batch[i];
+        }
     }
 
-    struct Directory *sourceDir = goTo(fs, inputSourcePath);
-    struct Directory *destinationDir = goTo(fs, inputDestPath);
-
-    if (sourceDir != NULL && destinationDir != NULL)
+    size_t next = 0;
+    while (next < pending)
     {
-        // Binary search in source directory to find the file
-        int left = 0;
-        int right = sourceDir->file_count - 1;
-        int found = 0;
-
-        while (left <= right)
+        // Gather the content of as many files as the budget holds
+        size_t slots = 0;
+        uint64_t held = 0;
+        for (; next < pending; ++next)
         {
-            int mid = left + (right - left) / 2;
-            int comparison = strcmp(sourceDir->files[mid]->name, fileName);
-
-            if (comparison == 0)
+            struct ExportJob *job = &export->jobs[worker->batch[next]];
+            if (slots > 0 && held + job->file->size > worker->budget)
             {
-                struct File *fileToMove = sourceDir->files[mid];
-
-                char newPath[MAX_PATH_LENGTH];
-                snprintf(newPath, MAX_PATH_LENGTH, "%s/%s", destinationDir->path, fileToMove->name);
-
-                // Check if the destination directory already contains a file with the same name
-                int fileExists = 0;
-                for (int i = 0; i < destinationDir->file_count; ++i)
-                {
-                    if (strcmp(destinationDir->files[i]->name, fileToMove->name) == 0)
-                    {
-                        printf("File '%s' already exists in '%s'. Cannot move.\n", fileName, destinationDir->name);
-                        return;
-                    }
-                }
-
-                snprintf(fileToMove->path, MAX_PATH_LENGTH, "%s", newPath);
-
-                // Add file to the destination directory
-                destinationDir->files[destinationDir->file_count++] = fileToMove;
-                sourceDir->files[mid] = NULL;
-                sourceDir->file_count--;
-
-                printf("File '%s' moved from '%s' to '%s'.\n", fileName, sourceDir->name, destinationDir->name);
-                found = 1;
                 break;
             }
+            char *owned = NULL;
+            const char *bytes = job->file->size > 0 ? contiguousFileContent(job->file, &owned) : "";
+            if (bytes == NULL)
+            {
+                job->result = -1;
+                continue;
+            }
+            struct HostIoRequest *open = &requests[slots];
+            memset(open, 0, sizeof(struct HostIoRequest));
+            open->op = HOST_IO_OPEN_WRITE;
+            open->path = job->host_path;
+            open->buffer = (void *)bytes;
+            worker->slots[slots] = worker->batch[next];
+            worker->buffers[slots] = owned;
+            held += job->file->size;
+            slots++;
+        }
+        runHostIo(&worker->queue, requests, slots);
 
-            if (comparison < 0)
+        // Preallocate and write every file that opened, then close them
+        size_t writes = 0;
+        for (size_t i = 0; i < slots; ++i)
+        {
+            const struct File *file = export->jobs[worker->slots[i]].file;
+            if (requests[i].failed || file->size == 0)
             {
-                left = mid + 1;
+                continue;
             }
-            else
+            struct HostIoRequest *preallocate = &requests[slots + writes++];
+            memset(preallocate, 0, sizeof(struct HostIoRequest));
+            preallocate->op = HOST_IO_PREALLOCATE;
+            preallocate->file = requests[i].file;
+            preallocate->length = file->size;
+            struct HostIoRequest *write = &requests[slots + writes++];
+            memset(write, 0, sizeof(struct HostIoRequest));
+            write->op = HOST_IO_WRITE;
+            write->file = requests[i].file;
+            write->buffer = requests[i].buffer;
+            write->length = file->size;
+        }
+        runHostIo(&worker->queue, requests + slots, writes);
+
+        // The writes follow the opened files in order, after their preallocations
+        size_t written = 0;
+        for (size_t i = 0; i < slots; ++i)
+        {
+            struct ExportJob *job = &export->jobs[worker->slots[i]];
+            const struct HostIoRequest *write = !requests[i].failed && job->file->size > 0 ? &requests[slots + 2 * written++ + 1] : NULL;
+            job->result = !requests[i].failed && (write == NULL || !write->failed) ? 1 : -1;
+            if (write != NULL && write->lost)
             {
-                right = mid - 1;
+                worker->buffers[i] = NULL; // The kernel may still read it
             }
         }
 
-        if (!found)
+        size_t closes = 0;
+        for (size_t i = 0; i < slots; ++i)
         {
-            printf("File '%s' not found in '%s'. Cannot move.\n", fileName, sourceDir->name);
+            if (!requests[i].failed)
+            {
+                struct HostIoRequest *close = &requests[slots + closes++];
+                memset(close, 0, sizeof(struct HostIoRequest));
+                close->op = HOST_IO_CLOSE;
+                close->file = requests[i].file;
+            }
+            free(worker->buffers[i]);
         }
-    }
-    else
-    {
-        printf("Invalid parameters provided. Cannot move file.\n");
+        runHostIo(&worker->queue, requests + slots, closes);
     }
 }
 
-void searchFileInPath(struct FileSystem *fs, const char *path, const char *fileName)
+static void exportWorkerMain(void *param)
 {
-    if (fs == NULL || path == NULL || fileName == NULL || isWhitespaceString(path) || isWhitespaceString(fileName))
+    struct HostIoWorker *worker = param;
+    struct HostExport *export = worker->owner;
+    size_t count;
+    long index;
+    if (export->batched)
     {
-        printf("Invalid parameters provided for file search.\n");
+        while ((count = claimHostIoBatch(&export->next, export->job_count, worker->batch, worker->depth)) > 0)
+        {
+            exportRunBatch(export, worker, count);
+        }
         return;
     }
-
-    // Check for potential buffer overflow in the path and fileName
-    if (strlen(path) >= MAX_PATH_LENGTH || strlen(fileName) >= MAX_FILE_NAME_LENGTH)
+    while ((index = atomicIncrement(&export->next) - 1) < (long)export->job_count)
     {
-        printf("Path or file name length exceeds maximum limit.\n");
-        return;
+        exportRunJob(&export->jobs[index]);
     }
+}
 
-    struct Directory *currentDir = goTo(fs, path);
+// Joins a host directory path and a name into a new string; NULL if memory runs out
+static char *joinHostPath(const char *directory, const char *name)
+{
+    size_t directoryLength = strlen(directory);
+    size_t nameLength = strlen(name);
+    int separated = directoryLength > 0 && directory[directoryLength - 1] == HOST_PATH_SEPARATOR;
+    char *path = malloc(directoryLength + nameLength + 2);
+    if (path != NULL)
+    {
+        memcpy(path, directory, directoryLength);
+        path[directoryLength] = HOST_PATH_SEPARATOR;
+        memcpy(path + directoryLength + !separated, name, nameLength + 1);
+    }
+    return path;
+}
 
-    if (currentDir != NULL)
+// Creates the host directories of the subtree at 'root' under 'hostPath' and queues every
+// file for the I/O workers; -1 if memory runs out
+static int exportScanTree(struct FileSystem *fs, struct HostExport *export, struct Directory *root, const char *hostPath)
+{
+    struct ExportDirectory
     {
-        int left = 0;
-        int right = currentDir->file_count - 1;
-        int found = 0;
+        uint32_t dir;
+        char *path;
+    } *stack = malloc(sizeof(struct ExportDirectory) * 64);
+    size_t depth = 0;
+    size_t capacity = 64;
+    int result = 0;
+
+    if (stack == NULL || (stack[0].path = strdup(hostPath)) == NULL)
+    {
+        free(stack);
+        return -1;
+    }
+    stack[0].dir = root->id;
+    depth = 1;
 
-        // Binary search in current directory
-        while (left <= right)
+    while (depth > 0 && result == 0)
+    {
+        struct ExportDirectory current = stack[--depth];
+        struct Directory *dir = fs->inodes.nodes[current.dir];
+        if (createHostDirectory(current.path) != 0)
         {
-            int mid = left + (right - left) / 2;
-            int comparison = strcmp(currentDir->files[mid]->name, fileName);
+            printf("Failed to create host directory '%s'.\n", current.path);
+            export->failed_directories++;
+            free(current.path);
+            continue;
+        }
+        export->directories++;
 
-            if (comparison == 0)
+        for (int i = 0; i < dir->files.count && result == 0; ++i)
+        {
+            char *path = joinHostPath(current.path, nodeName(fs, dir->files.ids[i]));
+            if (path == NULL)
             {
-                printf("File '%s' found at path: %s\n", fileName, currentDir->files[mid]->path);
-                found = 1;
+                result = -1;
                 break;
             }
 
-            if (comparison < 0)
-            {
-                left = mid + 1;
-            }
-            else
+            if (export->job_count == export->job_capacity)
             {
-                right = mid - 1;
+                size_t grown = export->job_capacity > 0 ? export->job_capacity * 2 : 256;
+                struct ExportJob *jobs = realloc(export->jobs, sizeof(struct ExportJob) * grown);
+                if (jobs == NULL)
+                {
+                    free(path);
+                    result = -1;
+                    break;
+                }
+                export->jobs = jobs;
+                export->job_capacity = grown;
             }
+            struct ExportJob *job = &export->jobs[export->job_count++];
+            job->file = fs->inodes.nodes[dir->files.ids[i]];
+            job->host_path = path;
+            job->result = -1;
         }
 
-        // Recursively search in subdirectories
-        for (int i = 0; i < currentDir->subdir_count; ++i)
-        {
-            searchFileInPath(fs, currentDir->subdirectories[i]->path, fileName);
-        }
-
-        if (!found)
+        for (int i = 0; i < dir->subdirectories.count && result == 0; ++i)
         {
-            printf("File '%s' not found in path: %s\n", fileName, path);
+            char *path = joinHostPath(current.path, nodeName(fs, dir->subdirectories.ids[i]));
+            if (path == NULL)
+            {
+                result = -1;
+                break;
+            }
+            if (depth == capacity)
+            {
+                struct ExportDirectory *grown = realloc(stack, sizeof(struct ExportDirectory) * capacity * 2);
+                if (grown == NULL)
+                {
+                    free(path);
+                    result = -1;
+                    break;
+                }
+                stack = grown;
+                capacity *= 2;
+            }
+            stack[depth].dir = dir->subdirectories.ids[i];
+            stack[depth].path = path;
+            depth++;
         }
+        free(current.path);
     }
-    else
+
+    while (depth > 0)
     {
-        printf("Invalid parameters provided for file search.\n");
+        free(stack[--depth].path);
     }
+    free(stack);
+    return result;
 }
 
-struct Directory *goTo1(struct FileSystem *fs, const char *path)
+// out -r: mirrors the subsystem directory at 'subsystemPath' into the host directory at
+// 'hostPath', creating it and every directory below it. Files are written by a bounded pool of
+// I/O workers, one per processor with the calling thread among them; a host file that already
+// has the same size and bytes is left alone, so repeated snapshots only write what changed.
+void outHostTree(struct FileSystem *fs, const char *subsystemPath, const char *hostPath)
 {
-    if (fs == NULL || path == NULL || isWhitespaceString(path))
+    if (fs == NULL || subsystemPath == NULL || hostPath == NULL)
     {
-        printf("Invalid parameters provided for directory navigation.\n");
-        return NULL;
+        printf("Invalid parameters for writing a directory to the host.\n");
+        return;
     }
 
-    // Check for potential buffer overflow in the path
-    if (strlen(path) >= MAX_PATH_LENGTH)
+    struct Directory *root = goTo(fs, subsystemPath);
+    if (root == NULL)
     {
-        printf("Path length exceeds maximum limit.\n");
-        return NULL;
+        printf("Directory not found at path: %s\n", subsystemPath);
+        return;
     }
 
-    char *inputPath = strdup(path);
-
-    if (strcmp(inputPath, ".") == 0)
+    double start = getMilliseconds();
+    struct HostExport export;
+    memset(&export, 0, sizeof(struct HostExport));
+    if (exportScanTree(fs, &export, root, hostPath) != 0)
     {
-        // Stay in the current directory
-        inputPath = getCurrentDirectoryPath(fs);
+        printf("Memory allocation failed while walking '%s'; writing the %zu files found so far.\n", subsystemPath, export.job_count);
     }
 
-    struct Directory *currentDir = fs->root;
-    char currentPath[MAX_PATH_LENGTH] = ""; // Track the current path
-
-    // Traversing through directories
-    char *token = strtok(inputPath, "/");
-    int firstdotfound = 0;
-
-    while (token != NULL)
+    int workerCount = walkWorkerCount();
+    struct HostIoWorker workers[WALK_MAX_WORKERS];
+    export.batched = initHostIoWorkers(fs, workers, workerCount, &export, 1);
+    PlatformThread threads[WALK_MAX_WORKERS];
+    int threadCount = 0;
+    for (int i = 1; i < workerCount && (size_t)i < export.job_count; ++i)
     {
-        if (strcmp(token, ".") == 0)
+        if (startPlatformThread(&threads[threadCount], exportWorkerMain, &workers[threadCount + 1]) == 0)
         {
-            if (!firstdotfound)
-            {
-                token = getCurrentDirectoryPath(fs);
-                firstdotfound = 1;
-            }
-            else
-            {
-                token = strtok(NULL, "/");
-                continue;
-            }
+            threadCount++;
         }
+    }
+    exportWorkerMain(&workers[0]);
+    for (int i = 0; i < threadCount; ++i)
+    {
+        joinPlatformThread(threads[i]);
+    }
+    char requests[128] = "";
+    if (export.batched)
+    {
+        describeHostIo(workers, workerCount, requests, sizeof(requests));
+    }
+    for (int i = 0; i < workerCount; ++i)
+    {
+        freeHostIoWorker(fs, &workers[i]);
+    }
 
-        // Check for individual directory name length
-        size_t dirNameLength = strlen(token);
-        if (dirNameLength >= MAX_FILE_NAME_LENGTH)
+    size_t written = 0;
+    size_t unchanged = 0;
+    size_t failed = 0;
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < export.job_count; ++i)
+    {
+        struct ExportJob *job = &export.jobs[i];
+        if (job->result < 0)
         {
-            printf("Directory name '%s' length exceeds maximum limit.\n", token);
-            return NULL;
+            printf("Failed to write host file '%s'.\n", job->host_path);
         }
+        written += job->result > 0;
+        unchanged += job->result == 0;
+        failed += job->result < 0;
+        bytes += job->result > 0 ? job->file->size : 0;
+        free(job->host_path);
+    }
+    free(export.jobs);
+
+    double milliseconds = getMilliseconds() - start;
+    double seconds = milliseconds / 1000.0;
+    printf("Wrote %zu files (%zu already up to date) and %zu directories to '%s' in %.3f ms using %d workers: "
+           "%llu bytes, %.0f files/s, %.1f MB/s.\n",
+           written, unchanged, export.directories, hostPath, milliseconds, threadCount + 1, (unsigned long long)bytes,
+           seconds > 0 ? (written + unchanged) / seconds : 0.0, seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0);
+    if (export.batched)
+    {
+        printf("%s.\n", requests);
+    }
+    if (failed > 0 || export.failed_directories > 0)
+    {
+        printf("%zu files and %zu directories could not be written.\n", failed, export.failed_directories);
+    }
+}
 
-        int found = 0;
-
-        // Binary search in sorted subdirectories
-        int low = 0;
-        int high = currentDir->subdir_count - 1;
-        while (low <= high)
+// Reads one host file of a recursive load through a mapping; runs on any thread and leaves the
+// namespace alone
+static void importMapJob(struct HostImport *import, struct ImportJob *job)
+{
+    struct HostMapping mapping;
+    if (import->options.lazy)
+    {
+        job->failed = recordHostFile(job->host_path, import->options.map.writable, &job->content, &job->size) != 0;
+    }
+    else if (mapHostFile(job->host_path, &import->options.map, &mapping) != 0)
+    {
+        job->failed = 1;
+    }
+    else if (mapping.data != NULL || mapping.writable)
+    {
+        job->size = mapping.size;
+        if (smallContentClass(mapping.size + 1) < SMALL_CLASS_COUNT && !mapping.writable)
         {
-            int mid = low + (high - low) / 2;
-            int comparison = strcmp(currentDir->subdirectories[mid]->name, token);
-
-            if (comparison == 0)
-            {
-                currentDir = currentDir->subdirectories[mid];
-                found = 1;
-
-                // Update the current path
-                if (strlen(currentPath) > 0)
-                {
-                    strncat(currentPath, "/", sizeof(currentPath) - strlen(currentPath) - 1);
-                }
-                strncat(currentPath, token, sizeof(currentPath) - strlen(currentPath) - 1);
-                break;
-            }
-            else if (comparison < 0)
+            job->small = malloc((size_t)mapping.size);
+            if (job->small != NULL)
             {
-                low = mid + 1;
+                memcpy(job->small, mapping.data, (size_t)mapping.size);
             }
-            else
+            job->failed = job->small == NULL;
+        }
+        else if (import->options.keep_mapping)
+        {
+            job->content = mappedContent(&mapping, job->host_path);
+            job->failed = job->content == NULL;
+            if (job->content != NULL)
             {
-                high = mid - 1;
+                mapping.data = NULL; // Now held by the content
             }
         }
-
-        if (!found)
+        else
         {
-            printf("Directory '%s' not found in path '%s'.\n", token, inputPath);
-            return NULL;
+            job->content = chunkContent(&import->fs->blocks, (const unsigned char *)mapping.data, mapping.size, job->compress);
+            job->failed = job->content == NULL;
         }
-
-        token = strtok(NULL, "/");
+        unmapHostFile(&mapping);
     }
-
-    fs->current_directory = currentDir;
-
-    // Update the path correctly
-    snprintf(fs->current_directory->path, MAX_PATH_LENGTH, "%s", currentPath);
-    free(inputPath);
-    return fs->current_directory;
 }
 
-struct Directory *goTo(struct FileSystem *fs, const char *path)
+// Reads a batch of claimed jobs through the worker's queue: the opens and host sizes of every
+// file go out as one round, the reads in rounds of as many files as the worker's buffer budget
+// holds, and the closes as a last round. Files bigger than the budget are mapped instead.
+static void importRunBatch(struct HostImport *import, struct HostIoWorker *worker, size_t count)
 {
-    if (fs == NULL || path == NULL || isWhitespaceString(path))
-    {
-        printf("Invalid parameters provided for directory navigation.\n");
-        return NULL;
-    }
-
-    // Check for potential buffer overflow in the path
-    if (strlen(path) >= MAX_PATH_LENGTH)
-    {
-        printf("Path length exceeds maximum limit.\n");
-        return NULL;
-    }
-
-    char *inputPath = strdup(path);
-
-    if (strcmp(inputPath, ".") == 0)
+    // Opens in the first third of the requests, sizes in the second, reads and closes in the last
+    struct HostIoRequest *opens = worker->requests;
+    struct HostIoRequest *sizes = opens + count;
+    struct HostIoRequest *rest = sizes + count;
+    for (size_t i = 0; i < count; ++i)
     {
-        // Stay in the current directory
-        inputPath = getCurrentDirectoryPath(fs);
+        memset(&opens[i], 0, sizeof(struct HostIoRequest));
+        opens[i].op = HOST_IO_OPEN_READ;
+        opens[i].path = import->jobs[worker->batch[i]].host_path;
+        memset(&sizes[i], 0, sizeof(struct HostIoRequest));
+        sizes[i].op = HOST_IO_SIZE;
+        sizes[i].path = opens[i].path;
     }
+    runHostIo(&worker->queue, opens, 2 * count);
 
-    struct Directory *currentDir = fs->root;
-    char currentPath[MAX_PATH_LENGTH] = ""; // Track the current path
-
-    // Traversing through directories
-    char *token = strtok(inputPath, "/");
-    int firstdotfound = 0;
-
-    while (token != NULL)
+    size_t next = 0;
+    while (next < count)
     {
-        if (strcmp(token, ".") == 0)
+        size_t reads = 0;
+        uint64_t held = 0;
+        for (; next < count; ++next)
         {
-            if (!firstdotfound)
+            struct ImportJob *job = &import->jobs[worker->batch[next]];
+            uint64_t size = sizes[next].length;
+            if (opens[next].failed || sizes[next].failed)
             {
-                token = getCurrentDirectoryPath(fs);
-                firstdotfound = 1;
+                job->failed = 1;
+                continue;
             }
-            else
+            if (size == 0)
             {
-                token = strtok(NULL, "/");
                 continue;
             }
-        }
-
-        // Check for individual directory name length
-        size_t dirNameLength = strlen(token);
-        if (dirNameLength >= MAX_FILE_NAME_LENGTH)
-        {
-            printf("Directory name '%s' length exceeds maximum limit.\n", token);
-            return NULL;
-        }
-
-        int found = 0;
-
-        // Binary search in sorted subdirectories
-        int low = 0;
-        int high = currentDir->subdir_count - 1;
-        while (low <= high)
-        {
-            int mid = low + (high - low) / 2;
-            int comparison = strcmp(currentDir->subdirectories[mid]->name, token);
-
-            if (comparison == 0)
+            if (size > worker->budget)
+            {
+                importMapJob(import, job);
+                continue;
+            }
+            if (reads > 0 && held + size > worker->budget)
             {
-                currentDir = currentDir->subdirectories[mid];
-                found = 1;
+                break;
+            }
 
-                // Update the current path
-                if (strcmp(currentPath, "") == 0)
-                {
-                    strncat(currentPath, token, sizeof(currentPath) - strlen(currentPath) - 1);
-                }
-                else
-                {
-                    strncat(currentPath, "/", sizeof(currentPath) - strlen(currentPath) - 1);
-                    strncat(currentPath, token, sizeof(currentPath) - strlen(currentPath) - 1);
-                }
+            void *buffer = malloc((size_t)size);
+            if (buffer == NULL)
+            {
+                job->failed = 1;
+                continue;
+            }
+            struct HostIoRequest *read = &rest[reads];
+            memset(read, 0, sizeof(struct HostIoRequest));
+            read->op = HOST_IO_READ;
+            read->file = opens[next].file;
+            read->buffer = buffer;
+            read->length = size;
+            worker->slots[reads++] = worker->batch[next];
+            held += size;
+        }
+        runHostIo(&worker->queue, rest, reads);
 
-                break;
+        // A file that shrank since its size was taken reads short and keeps what it holds
+        for (size_t i = 0; i < reads; ++i)
+        {
+            struct ImportJob *job = &import->jobs[worker->slots[i]];
+            job->size = rest[i].done;
+            job->failed = rest[i].failed;
+            if (!job->failed && smallContentClass(job->size + 1) < SMALL_CLASS_COUNT)
+            {
+                job->small = rest[i].buffer;
+                continue;
             }
-            else if (comparison < 0)
+            if (!job->failed)
             {
-                low = mid + 1;
+                job->content = chunkContent(&import->fs->blocks, rest[i].buffer, job->size, job->compress);
+                job->failed = job->content == NULL;
             }
-            else
+            if (!rest[i].lost)
             {
-                high = mid - 1;
+                free(rest[i].buffer);
             }
         }
+    }
 
-        if (!found)
+    size_t closes = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!opens[i].failed)
         {
-            printf("Directory '%s' not found in path '%s'.\n", token, inputPath);
-            return NULL;
+            memset(&rest[closes], 0, sizeof(struct HostIoRequest));
+            rest[closes].op = HOST_IO_CLOSE;
+            rest[closes++].file = opens[i].file;
         }
-
-        token = strtok(NULL, "/");
     }
-
-    free(inputPath);
-    return currentDir;
+    runHostIo(&worker->queue, rest, closes);
+    for (size_t i = 0; i < count; ++i)
+    {
+        atomicIncrement(&import->jobs[worker->batch[i]].done);
+    }
 }
 
-void displayCurrentDirectory(struct FileSystem *fs, const char *path)
+// Claims and runs the next job, or the next batch of jobs when the load is batched; 0 once
+// every job has been claimed
+static int importClaimWork(struct HostIoWorker *worker)
 {
-    if (fs == NULL || path == NULL)
+    struct HostImport *import = worker->owner;
+    if (import->batched)
     {
-        printf("Invalid parameters provided for directory display.\n");
-        return;
+        size_t count = claimHostIoBatch(&import->next, import->job_count, worker->batch, worker->depth);
+        if (count > 0)
+        {
+            importRunBatch(import, worker, count);
+        }
+        return count > 0;
     }
 
-    // Check for potential buffer overflow in the path
-    if (strlen(path) >= MAX_PATH_LENGTH)
+    long index = atomicIncrement(&import->next) - 1;
+    if (index >= (long)import->job_count)
     {
-        printf("Path length exceeds maximum limit.\n");
-        return;
+        return 0;
     }
+    importMapJob(import, &import->jobs[index]);
+    atomicIncrement(&import->jobs[index].done);
+    return 1;
+}
 
-    char *inputPath = path;
-
-    if (strcmp(inputPath, ".") == 0)
+static void importWorkerMain(void *param)
+{
+    while (importClaimWork(param))
     {
-        inputPath = getCurrentDirectoryPath(fs);
     }
+}
 
-    struct Directory *currentDir = goTo(fs, inputPath);
-
-    if (currentDir != NULL)
+// Creates or refills the subsystem file of a finished job, on the loading thread only.
+// Returns 1 for a new file, 0 for a replaced one, -1 if it could not be loaded.
+static int importAttachFile(struct FileSystem *fs, struct ImportJob *job)
+{
+    struct Directory *parentDir = fs->inodes.nodes[job->parent];
+    struct File *file = findFile(fs, parentDir, job->name);
+    int created = file == NULL;
+    if (!job->failed && file == NULL && findSubdirectory(fs, parentDir, job->name) == NULL)
     {
-        printf("Current Directory: %s\n", currentDir->name);
-        printf("Path: %s\n", currentDir->path);
-        printf("Files and Directories in the first level:\n");
-
-        // Display files in the directory if they exist
-        printf("Files:\n");
-        if (currentDir->file_count > 0)
-        {
-            for (int i = 0; i < currentDir->file_count; ++i)
-            {
-                if (currentDir->files[i] != NULL)
-                {
-                    printf("File %d: %s\n", i + 1, currentDir->files[i]->name);
-                }
-            }
-        }
-        else
-        {
-            printf("No files in '%s'.\n", currentDir->path);
-        }
+        file = newFileNode(fs, parentDir, job->name);
+    }
 
-        // Display directories in the directory if they exist
-        printf("Directories:\n");
-        if (currentDir->subdir_count > 0)
-        {
-            for (int i = 0; i < currentDir->subdir_count; ++i)
-            {
-                if (currentDir->subdirectories[i] != NULL)
-                {
-                    printf("Directory %d: %s\n", i + 1, currentDir->subdirectories[i]->name);
-                }
-            }
-        }
-        else
+    int result = -1;
+    if (job->failed || file == NULL)
+    {
+        if (job->content != NULL)
         {
-            printf("No directories in '%s'.\n", currentDir->path);
+            releaseContent(job->content, job->size);
         }
     }
-    else
+    else if (job->content != NULL)
     {
-        printf("Invalid directory or path provided for display.\n");
+        releaseFileContent(fs, file);
+        file->content = job->content;
+        file->size = job->size;
+        result = created;
+    }
+    else if (setFileContent(fs, file, job->small, job->size) == 0)
+    {
+        result = created;
     }
-}
 
-void displayFileInDirectory(struct FileSystem *fs, const char *path, const char *fileName)
-{
-    if (fs == NULL || path == NULL || fileName == NULL || isWhitespaceString(fileName))
+    if (result >= 0)
     {
-        printf("Invalid parameters provided for file display.\n");
-        return;
+        updateTrigramIndex(fs, file);
     }
+    free(job->small);
+    job->small = NULL;
+    job->content = NULL;
+    return result;
+}
 
-    // Check the length of fileName and path
-    size_t fileNameLength = strlen(fileName);
-    size_t pathLength = strlen(path);
-    if (fileNameLength == 0 || fileNameLength >= MAX_FILE_NAME_LENGTH || pathLength >= MAX_PATH_LENGTH)
+// Queues one host file of the walk; -1 if memory runs out
+static int importQueueFile(struct HostImport *import, char *hostPath, size_t nameOffset, uint32_t parent)
+{
+    if (import->job_count == import->job_capacity)
     {
-        printf("Invalid file name or path length.\n");
-        return;
+        size_t capacity = import->job_capacity > 0 ? import->job_capacity * 2 : 256;
+        struct ImportJob *jobs = realloc(import->jobs, sizeof(struct ImportJob) * capacity);
+        if (jobs == NULL)
+        {
+            return -1;
+        }
+        import->jobs = jobs;
+        import->job_capacity = capacity;
     }
 
-    char *inputPath = path;
+    struct ImportJob *job = &import->jobs[import->job_count++];
+    memset(job, 0, sizeof(struct ImportJob));
+    job->host_path = hostPath;
+    job->name = hostPath + nameOffset;
+    job->parent = parent;
+    job->compress = isContentCompressed(import->fs, parent);
+    return 0;
+}
 
-    if (strcmp(inputPath, ".") == 0)
+// Walks the host tree depth first, creating the subsystem directories as they are found and
+// queuing every file for the I/O workers
+static int importScanHostTree(struct HostImport *import, const char *hostPath, struct Directory *root)
+{
+    struct FileSystem *fs = import->fs;
+    struct ImportDirectory
     {
-        // Stay in the current directory
-        inputPath = getCurrentDirectoryPath(fs);
+        char *path;
+        uint32_t dir;
+    } *stack = malloc(sizeof(struct ImportDirectory) * 64);
+    size_t depth = 0;
+    size_t capacity = 64;
+    int result = 0;
+
+    if (stack == NULL || (stack[0].path = strdup(hostPath)) == NULL)
+    {
+        free(stack);
+        return -1;
     }
+    stack[0].dir = root->id;
+    depth = 1;
 
-    struct Directory *currentDir = goTo(fs, inputPath);
-
-    if (currentDir != NULL)
+    while (depth > 0)
     {
-        int found = 0;
-        for (int i = 0; i < currentDir->file_count; ++i)
+        struct ImportDirectory current = stack[--depth];
+        struct HostDirectory hostDir;
+        if (openHostDirectory(current.path, &hostDir) != 0)
+        {
+            printf("Failed to read host directory '%s'.\n", current.path);
+            import->skipped++;
+            free(current.path);
+            continue;
+        }
+
+        const char *name;
+        int isDirectory;
+        while (result == 0 && (name = nextHostEntry(&hostDir, &isDirectory)) != NULL)
         {
-            if (currentDir->files[i] != NULL && strncmp(currentDir->files[i]->name, fileName, MAX_FILE_NAME_LENGTH) == 0)
+            size_t nameLength = strlen(name);
+            if (nameLength >= MAX_FILE_NAME_LENGTH)
             {
-                printf("File Name: %s\n", currentDir->files[i]->name);
-                printf("File Path: %s\n", currentDir->files[i]->path);
-                printf("File Size: %d bytes\n", currentDir->files[i]->size);
+                import->skipped++;
+                continue;
+            }
 
-                // Check if content exists before displaying
-                if (currentDir->files[i]->fileContent != NULL)
-                {
-                    char *fileContent = (char *)currentDir->files[i]->fileContent;
-                    printf("File Content:\n%s\n", fileContent);
-                }
-                else
+            char *path = joinHostPath(current.path, name);
+            if (path == NULL)
+            {
+                result = -1;
+                break;
+            }
+
+            struct Directory *parentDir = fs->inodes.nodes[current.dir];
+            if (!isDirectory)
+            {
+                if (importQueueFile(import, path, strlen(path) - nameLength, current.dir) != 0)
                 {
-                    printf("File Content: Not available\n");
+                    free(path);
+                    result = -1;
                 }
+                continue;
+            }
 
-                found = 1;
-                break;
+            struct Directory *dir = findSubdirectory(fs, parentDir, name);
+            if (dir == NULL && findFile(fs, parentDir, name) == NULL && (dir = newDirectoryNode(fs, parentDir, name)) != NULL)
+            {
+                import->directories++;
+            }
+            if (dir == NULL)
+            {
+                import->skipped++;
+                free(path);
+                continue;
             }
-        }
 
-        if (!found)
-        {
-            printf("File '%s' not found in the directory '%s'.\n", fileName, path);
+            if (depth == capacity)
+            {
+                struct ImportDirectory *grown = realloc(stack, sizeof(struct ImportDirectory) * capacity * 2);
+                if (grown == NULL)
+                {
+                    free(path);
+                    result = -1;
+                    break;
+                }
+                stack = grown;
+                capacity *= 2;
+            }
+            stack[depth].path = path;
+            stack[depth].dir = dir->id;
+            depth++;
         }
+        closeHostDirectory(&hostDir);
+        free(current.path);
     }
-    else
+
+    while (depth > 0)
     {
-        printf("Directory not found or invalid path provided.\n");
+        free(stack[--depth].path);
     }
+    free(stack);
+    return result;
 }
 
-void changeDirectoryAccessLevel(struct FileSystem *fs, const char *dirPath, enum AuthorityLevel newAccessLevel)
+// hostio: picks how recursive load and out reach the host. "uring" batches each worker's
+// files through its own io_uring, 'queueDepth' requests and an equal share of
+// 'inflightMegabytes' of buffers at a time; "threads" has each worker map or write one file at
+// a time. A depth or limit of 0 keeps the current value.
+void setHostIo(struct FileSystem *fs, const char *backend, unsigned queueDepth, unsigned inflightMegabytes)
 {
-    if (fs == NULL || dirPath == NULL)
+    if (fs == NULL || backend == NULL || (strcmp(backend, "uring") != 0 && strcmp(backend, "threads") != 0))
     {
-        printf("Invalid parameter detected.\n");
+        printf("Invalid parameters provided for host I/O.\n");
         return;
     }
-
-    // Check for potential buffer overflow in the directory path
-    if (strlen(dirPath) >= MAX_PATH_LENGTH)
+    if (queueDepth > 4096)
     {
-        printf("Directory path length exceeds maximum limit.\n");
+        printf("Queue depth must be at most 4096.\n");
         return;
     }
 
-    // Check if the newAccessLevel is a valid AuthorityLevel value
-    if (newAccessLevel < LOW || newAccessLevel > HIGHEST)
+    fs->host_io.backend = strcmp(backend, "uring") == 0 ? HOST_IO_URING : HOST_IO_THREADS;
+    if (queueDepth > 0)
     {
-        printf("Invalid AuthorityLevel specified.\n");
-        return;
+        fs->host_io.queue_depth = queueDepth;
     }
-
-    char *inputPath = dirPath;
-
-    if (strcmp(inputPath, ".") == 0)
+    if (inflightMegabytes > 0)
     {
-        inputPath = getCurrentDirectoryPath(fs);
+        fs->host_io.inflight_bytes = (uint64_t)inflightMegabytes << 20;
     }
 
-    struct Directory *targetDir = goTo(fs, inputPath);
-    if (targetDir != NULL && targetDir->subdir_count > 0)
-    {
-        for (int i = 0; i < targetDir->subdir_count; ++i)
-        {
-            if (targetDir->subdirectories[i] != NULL)
-            {
-                targetDir->subdirectories[i]->access = newAccessLevel;
-            }
-        }
-        printf("Directory access level changed successfully.\n");
-    }
-    else
+    if (fs->host_io.backend == HOST_IO_THREADS)
     {
-        printf("Directory not found or invalid path provided.\n");
+        printf("Recursive load and out now map or write one file at a time on each worker.\n");
+        return;
     }
+
+    struct HostIoQueue probe;
+    int uring = initHostIoQueue(&probe, 1, 1);
+    freeHostIoQueue(&probe);
+    printf("Recursive load and out now batch %u requests per worker with up to %llu MB of buffers in flight%s.\n",
+           fs->host_io.queue_depth, (unsigned long long)(fs->host_io.inflight_bytes >> 20),
+           uring ? " through io_uring" : "; io_uring is not available here, so batches use blocking calls");
 }
 
-int loadFileContent(const char *fileName, const char *windowsPath, const char *subsystemPath, struct FileSystem *fs)
+// load -r: copies a host directory tree into the subsystem directory at 'subsystemPath'.
+// Directories are created while the host tree is walked; host files are then mapped and
+// chunked on a pool of I/O workers, and the calling thread inserts the finished files into
+// the namespace in order, in batches, taking jobs itself whenever the next file is not ready.
+void loadHostTree(struct FileSystem *fs, const char *hostPath, const char *subsystemPath, const struct LoadOptions *options)
 {
-    if (fileName == NULL || windowsPath == NULL || subsystemPath == NULL || fs == NULL || isWhitespaceString(fileName))
+    if (fs == NULL || hostPath == NULL || subsystemPath == NULL || options == NULL)
     {
-        printf("Invalid parameters for loading file content.\n");
-        return -1;
+        printf("Invalid parameters for loading a host directory.\n");
+        return;
     }
 
-    struct File *file = getFileInDirectory(fs, subsystemPath, fileName);
-    if (file == NULL)
+    struct Directory *root = goTo(fs, subsystemPath);
+    if (root == NULL)
     {
-        printf("File '%s' not found in the given subsystem path '%s'.\n", fileName, subsystemPath);
-        return -1;
+        printf("Directory not found at path: %s\n", subsystemPath);
+        return;
     }
 
-    // Open the Windows file
-    HANDLE hFile = CreateFile(windowsPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hFile == INVALID_HANDLE_VALUE)
+    struct HostImport import;
+    memset(&import, 0, sizeof(struct HostImport));
+    import.fs = fs;
+    import.options = *options;
+    if (!options->keep_mapping && import.options.map.hint == ACCESS_NORMAL)
     {
-        printf("Failed to open Windows file '%s'.\n", windowsPath);
-        return -1;
+        import.options.map.hint = ACCESS_SEQUENTIAL;
     }
 
-    // Get file size
-    DWORD fileSize = GetFileSize(hFile, NULL);
-    if (fileSize == INVALID_FILE_SIZE)
+    struct HostDirectory hostDir;
+    if (openHostDirectory(hostPath, &hostDir) != 0)
     {
-        printf("Invalid file size for Windows file '%s'.\n", windowsPath);
-        CloseHandle(hFile);
-        return -1;
+        printf("Failed to read host directory '%s'.\n", hostPath);
+        return;
     }
+    closeHostDirectory(&hostDir);
 
-    // Map the file content to the process address space
-    HANDLE hMapFile = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, fileSize, NULL);
-    CloseHandle(hFile); // Close the file handle
-
-    if (hMapFile == NULL)
+    double start = getMilliseconds();
+    if (importScanHostTree(&import, hostPath, root) != 0)
     {
-        printf("Failed to map Windows file '%s'.\n", windowsPath);
-        return -1;
+        printf("Memory allocation failed while walking host directory '%s'; loading the %zu files found so far.\n",
+               hostPath, import.job_count);
     }
 
-    LPVOID fileContent = MapViewOfFile(hMapFile, FILE_MAP_READ, 0, 0, fileSize);
-    CloseHandle(hMapFile); // Close the file mapping handle
-
-    if (fileContent == NULL)
+    // Files kept as mappings are mapped by unbatched workers
+    int workerCount = walkWorkerCount();
+    struct HostIoWorker workers[WALK_MAX_WORKERS];
+    import.batched = initHostIoWorkers(fs, workers, workerCount, &import, !options->keep_mapping);
+    PlatformThread threads[WALK_MAX_WORKERS];
+    int threadCount = 0;
+    for (int i = 1; i < workerCount && (size_t)i < import.job_count; ++i)
     {
-        printf("Failed to map view Windows file '%s'.\n", windowsPath);
-        return -1;
+        if (startPlatformThread(&threads[threadCount], importWorkerMain, &workers[threadCount + 1]) == 0)
+        {
+            threadCount++;
+        }
     }
 
-    // Update the found file in the subsystem with the loaded content
-    // Free any existing content to avoid memory leaks
-    if (file->fileContent != NULL)
+    size_t created = 0;
+    size_t replaced = 0;
+    size_t failed = 0;
+    size_t inserted = 0;
+    uint64_t bytes = 0;
+    double lastReport = getMilliseconds();
+    while (inserted < import.job_count)
     {
-        UnmapViewOfFile(file->fileContent);
-    }
+        size_t ready = inserted;
+        while (ready < import.job_count && atomicRead(&import.jobs[ready].done))
+        {
+            ready++;
+        }
+        if (ready == inserted)
+        {
+            if (!importClaimWork(&workers[0]))
+            {
+                yieldPlatformThread();
+            }
+            continue;
+        }
 
-    file->fileContent = fileContent;
-    file->size = fileSize;
+        for (; inserted < ready; ++inserted)
+        {
+            int result = importAttachFile(fs, &import.jobs[inserted]);
+            if (result < 0)
+            {
+                printf("Failed to load host file '%s'.\n", import.jobs[inserted].host_path);
+            }
+            bytes += result >= 0 ? import.jobs[inserted].size : 0;
+            created += result > 0;
+            replaced += result == 0;
+            failed += result < 0;
+        }
 
-    return 0;
-}
+        if (getMilliseconds() - lastReport >= 1000.0)
+        {
+            lastReport = getMilliseconds();
+            printf("Loaded %zu of %zu files (%.1f MB)...\n", inserted, import.job_count,
+                   bytes / (1024.0 * 1024.0));
+        }
+    }
 
-int outFileContent(const char *fileName, const char *subsystemPath, const char *windowsPath, struct FileSystem *fs)
-{
-    if (fileName == NULL || windowsPath == NULL || subsystemPath == NULL || fs == NULL)
+    for (int i = 0; i < threadCount; ++i)
     {
-        printf("Invalid parameters for writing file content.\n");
-        return -1;
+        joinPlatformThread(threads[i]);
     }
-
-    struct File *file = getFileInDirectory(fs, subsystemPath, fileName);
-    if (file == NULL || file->fileContent == NULL)
+    char requests[128] = "";
+    if (import.batched)
     {
-        printf("File '%s' not found in the given subsystem path '%s' or no content available.\n", fileName, subsystemPath);
-        return -1;
+        describeHostIo(workers, workerCount, requests, sizeof(requests));
     }
-
-    // Open the Windows file
-    HANDLE hFile = CreateFile(windowsPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hFile == INVALID_HANDLE_VALUE)
+    for (int i = 0; i < workerCount; ++i)
     {
-        printf("Failed to open Windows file '%s' for writing.\n", windowsPath);
-        return -1;
+        freeHostIoWorker(fs, &workers[i]);
     }
-
-    // Write the content to the Windows file
-    DWORD bytesWritten;
-    if (!WriteFile(hFile, file->fileContent, file->size, &bytesWritten, NULL) || bytesWritten != file->size)
+    for (size_t i = 0; i < import.job_count; ++i)
     {
-        printf("Failed to write content to Windows file '%s'.\n", windowsPath);
-        CloseHandle(hFile);
-        return -1;
+        free(import.jobs[i].host_path);
+    }
+    free(import.jobs);
+
+    double milliseconds = getMilliseconds() - start;
+    double seconds = milliseconds / 1000.0;
+    printf("Loaded %zu files (%zu new, %zu replaced) and %zu new directories from '%s' in %.3f ms using %d workers: "
+           "%.0f files/s, %.1f MB/s.\n",
+           created + replaced, created, replaced, import.directories, hostPath, milliseconds, threadCount + 1,
+           seconds > 0 ? (created + replaced) / seconds : 0.0,
+           seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0);
+    if (import.batched)
+    {
+        printf("%s.\n", requests);
+    }
+    if (options->lazy)
+    {
+        printf("Host files were only recorded; each is mapped when first read.\n");
+    }
+    if (failed > 0 || import.skipped > 0)
+    {
+        printf("%zu files failed to load; %zu host entries skipped.\n", failed, import.skipped);
     }
-
-    CloseHandle(hFile);
-    return 0;
 }
 
 char *getCurrentDirectoryPath(struct FileSystem *fs)
@@ -1756,7 +8624,12 @@ char *getCurrentDirectoryPath(struct FileSystem *fs)
         return NULL;
     }
 
-    char *currentPath = strdup(fs->current_directory->path);
+    size_t length = buildDirectoryPath(fs, fs->current_directory->id, NULL, 0);
+    char *currentPath = malloc(length + 1);
+    if (currentPath != NULL)
+    {
+        buildDirectoryPath(fs, fs->current_directory->id, currentPath, length + 1);
+    }
 
     return currentPath;
 }
@@ -1783,12 +8656,10 @@ struct File *getFileInDirectory(struct FileSystem *fs, const char *path, const c
 
     if (dir != NULL)
     {
-        for (int i = 0; i < dir->file_count; ++i)
+        struct File *file = findFile(fs, dir, fileName);
+        if (file != NULL)
         {
-            if (dir->files[i] != NULL && strncmp(dir->files[i]->name, fileName, MAX_FILE_NAME_LENGTH) == 0)
-            {
-                return dir->files[i];
-            }
+            return file;
         }
     }
 
@@ -1796,6 +8667,159 @@ struct File *getFileInDirectory(struct FileSystem *fs, const char *path, const c
     return NULL;
 }
 
+void displayFileSystemStats(struct FileSystem *fs)
+{
+    if (fs == NULL)
+    {
+        printf("Invalid file system provided.\n");
+        return;
+    }
+
+    unsigned long lookups = fs->dcache.hits + fs->dcache.misses;
+    printf("Dentry cache: %lu hits, %lu misses (%.1f%% hit rate), %lu invalidations\n",
+           fs->dcache.hits, fs->dcache.misses,
+           lookups > 0 ? 100.0 * fs->dcache.hits / lookups : 0.0,
+           fs->dcache.invalidations);
+
+    const struct InodeTable *table = &fs->inodes;
+    size_t nodeCount = (size_t)table->file_count + table->dir_count;
+
+    size_t tableBytes = (size_t)table->capacity * (sizeof(unsigned char) + sizeof(uint32_t) + sizeof(const char *) + sizeof(void *));
+    size_t heapBytes = fs->names.bytes_used + fs->names.slot_count * sizeof(struct InternedName);
+    size_t heapReserved = (size_t)fs->names.block_count * STRING_HEAP_BLOCK_SIZE;
+    size_t structBytes = (size_t)table->file_count * fs->file_slab.object_size + (size_t)table->dir_count * fs->dir_slab.object_size;
+    size_t indexBytes = 0;
+
+    for (uint32_t id = 0; id < table->count; ++id)
+    {
+        if (table->kinds[id] == INODE_DIR)
+        {
+            struct Directory *dir = table->nodes[id];
+            indexBytes += (size_t)(dir->files.capacity + dir->subdirectories.capacity) * sizeof(uint32_t);
+            indexBytes += (size_t)(dir->files.slot_count + dir->subdirectories.slot_count) * sizeof(int);
+        }
+    }
+
+    size_t nameIndexBytes = fs->name_index.slot_count * sizeof(struct NamePosting);
+    for (size_t i = 0; i < fs->name_index.slot_count; ++i)
+    {
+        nameIndexBytes += (size_t)fs->name_index.slots[i].capacity * sizeof(uint32_t);
+    }
+
+    size_t totalBytes = tableBytes + heapBytes + structBytes + indexBytes + nameIndexBytes;
+
+    // The layout before the inode table: fixed name and path arrays, 100 file and 50 subdirectory slots
+    size_t fixedFileBytes = MAX_FILE_NAME_LENGTH + MAX_PATH_LENGTH + 2 * sizeof(void *) + sizeof(int);
+    size_t fixedDirBytes = MAX_FILE_NAME_LENGTH + MAX_PATH_LENGTH + 150 * sizeof(void *) + 3 * sizeof(int);
+    size_t fixedBytes = (size_t)table->file_count * fixedFileBytes + (size_t)table->dir_count * fixedDirBytes;
+
+    printf("Nodes: %u files, %u directories (%u inode ids, %u capacity)\n",
+           table->file_count, table->dir_count, table->count, table->capacity);
+    printf("Names: %zu unique, %zu of %zu heap bytes used, %lu interned duplicates\n",
+           fs->names.name_count, fs->names.bytes_used, heapReserved, fs->names.intern_hits);
+    printf("Memory: inode table %zu, name heap %zu, node structs %zu, child indexes %zu, name index %zu bytes\n",
+           tableBytes, heapBytes, structBytes, indexBytes, nameIndexBytes);
+    // Copies share content, so each file accounts for its share of the physical bytes;
+    // chunked content is counted once, through the block store, and small content by the
+    // bytes it holds inline or the slab object it fills. Mapped and lazy content stays in
+    // its host file and is counted apart, so it is neither physical nor saved.
+    const struct BlockStore *store = &fs->blocks;
+    uint64_t logicalBytes = 0;
+    double physicalBytes = (double)store->stored_bytes;
+    double hostBytes = 0;
+    size_t sharedFiles = 0;
+    size_t inlineFiles = 0;
+    size_t packedFiles = 0;
+    size_t packedBytes = 0;
+    size_t mappedFiles = 0;
+    uint64_t mappedBytes = 0;
+    size_t writableFiles = 0;
+    uint64_t dirtyBytes = 0;
+    size_t deferredFiles = 0;
+    size_t unavailableFiles = 0;
+    uint64_t deferredBytes = 0;
+    for (uint32_t id = 0; id < table->count; ++id)
+    {
+        if (table->kinds[id] == INODE_FILE)
+        {
+            const struct File *file = table->nodes[id];
+            logicalBytes += file->size;
+            if (file->small == file->inline_data)
+            {
+                inlineFiles++;
+                physicalBytes += file->size;
+            }
+            else if (file->small != NULL)
+            {
+                packedFiles++;
+                packedBytes += (size_t)SMALL_CLASS_MIN << smallContentClass(file->size + 1);
+            }
+            else if (file->content != NULL)
+            {
+                int deferred = file->content->state != CONTENT_READY;
+                double share = (double)file->size / file->content->refs;
+                physicalBytes += file->content->store == NULL && !file->content->mapped ? share : 0;
+                hostBytes += file->content->mapped ? share : 0;
+                sharedFiles += file->content->refs > 1;
+                mappedFiles += file->content->mapped && !deferred;
+                mappedBytes += file->content->mapped && !deferred ? file->size : 0;
+                deferredFiles += deferred;
+                unavailableFiles += file->content->state == CONTENT_UNAVAILABLE;
+                deferredBytes += deferred ? file->size : 0;
+                writableFiles += file->content->writable;
+                for (uint32_t d = 0; d < file->content->dirty_count; ++d)
+                {
+                    dirtyBytes += file->content->dirty[d].end - file->content->dirty[d].start;
+                }
+            }
+        }
+    }
+    physicalBytes += packedBytes;
+    double savedBytes = logicalBytes - physicalBytes - hostBytes;
+    printf("Content: %llu logical bytes, %.0f physical bytes (%.0f saved), %zu files sharing content with a copy\n",
+           (unsigned long long)logicalBytes, physicalBytes, savedBytes > 0 ? savedBytes : 0.0, sharedFiles);
+    printf("Host-backed content: %.0f bytes served from host files by mapped and lazy files\n", hostBytes);
+    printf("Small files: %zu inline in their nodes, %zu in packed slabs using %zu bytes\n", inlineFiles, packedFiles, packedBytes);
+    printf("Mapped files: %zu served from host file views holding %llu bytes; %zu writable with %llu bytes of dirty pages\n",
+           mappedFiles, (unsigned long long)mappedBytes, writableFiles, (unsigned long long)dirtyBytes);
+    printf("Lazy files: %zu recorded and not yet mapped, holding %llu host bytes; %zu changed on the host since\n",
+           deferredFiles, (unsigned long long)deferredBytes, unavailableFiles);
+    printf("Host I/O: %s, queue depth %u, %llu MB in flight; %lu batched requests in %lu system calls%s\n",
+           fs->host_io.backend == HOST_IO_URING ? "batched" : "one file at a time", fs->host_io.queue_depth,
+           (unsigned long long)(fs->host_io.inflight_bytes >> 20), fs->host_io.operations, fs->host_io.system_calls,
+           fs->host_io.uring_missing ? " (io_uring unavailable, blocking calls used)" : "");
+    printf("Block store: %zu blocks holding %llu bytes for %llu referenced bytes; %lu chunks cut, %lu deduplicated, %.3f ms chunking\n",
+           store->block_count, (unsigned long long)store->stored_bytes, (unsigned long long)store->referenced_bytes,
+           store->chunks, store->duplicates, store->chunk_milliseconds);
+    double decompressSeconds = (double)store->decompress_nanoseconds / 1e9;
+    printf("Compression: %zu blocks, %llu bytes stored as %llu (%.2fx) in %.3f ms; %llu bytes decompressed at %.1f MB/s\n",
+           store->compressed_blocks, (unsigned long long)store->compressed_input_bytes, (unsigned long long)store->compressed_bytes,
+           store->compressed_bytes > 0 ? (double)store->compressed_input_bytes / store->compressed_bytes : 1.0,
+           store->compress_milliseconds, (unsigned long long)store->decompressed_bytes,
+           decompressSeconds > 0 ? store->decompressed_bytes / decompressSeconds / (1024.0 * 1024.0) : 0.0);
+    printf("Trigram index: %zu files (%llu bytes) indexed in %.3f ms; %zu trigrams, %zu live and %zu stale postings, %zu bytes; %lu queries, %lu compactions\n",
+           fs->trigrams.indexed_files, (unsigned long long)fs->trigrams.indexed_bytes, fs->trigrams.build_milliseconds,
+           fs->trigrams.trigram_count, fs->trigrams.live_postings, fs->trigrams.stale_postings,
+           trigramIndexBytes(&fs->trigrams), fs->trigrams.queries, fs->trigrams.compactions);
+
+    const struct Slab *slabs[] = {&fs->file_slab, &fs->dir_slab, &fs->small_slabs[0], &fs->small_slabs[1], &fs->small_slabs[2], &fs->small_slabs[3]};
+    const char *slabNames[] = {"File", "Directory", "64-byte content", "128-byte content", "256-byte content", "512-byte content"};
+    for (int i = 0; i < 6; ++i)
+    {
+        size_t carved = slabs[i]->chunk_count > 0 ? (size_t)(slabs[i]->chunk_count - 1) * SLAB_OBJECTS_PER_CHUNK + slabs[i]->chunk_used : 0;
+        size_t reserved = (size_t)slabs[i]->chunk_count * SLAB_OBJECTS_PER_CHUNK;
+        printf("%s slab: %zu live, %zu free (%zu recycled), %zu bytes reserved in %d chunks\n",
+               slabNames[i], slabs[i]->live, reserved - carved + slabs[i]->free, slabs[i]->free,
+               reserved * slabs[i]->object_size, slabs[i]->chunk_count);
+    }
+
+    if (nodeCount > 0)
+    {
+        printf("Memory per node: %zu bytes (fixed-array layout: %zu bytes)\n",
+               totalBytes / nodeCount, fixedBytes / nodeCount);
+    }
+}
+
 char *getCurrentUser(struct FileSystem *fs)
 {
     if (fs == NULL)
@@ -1803,5 +8827,5 @@ char *getCurrentUser(struct FileSystem *fs)
         return NULL;
     }
 
-    return fs->current_user.username;
+    return strdup(fs->current_user.username);
 }
@@ -1,26 +1,54 @@
 #ifndef FILESYSTEM_H
 #define FILESYSTEM_H
 
+#ifndef _WIN32
+#define _GNU_SOURCE           // mmap flags, madvise and friends
+#define _FILE_OFFSET_BITS 64 // 64-bit file sizes on 32-bit systems too
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+#ifdef _WIN32
 #include <windows.h>
+#include <conio.h>
+#else
+#include <dirent.h>
+#include <pthread.h>
+#endif
 #include <time.h>
 
-#define MAX_FILES 100
-#define MAX_CONTENT_SIZE 1000
 #define MAX_DIRS 50
 #define MAX_PATH_LENGTH 500
 #define MAX_USERNAME_LENGTH 50
 #define MAX_PASSWORD_LENGTH 50
 #define MAX_USERS 10
-#define MAX_SUB_DIRS 50
 #define MAX_FILE_NAME_LENGTH 255
 #define MAX_CHARS 255
 #define MAX_LOGIN_ATTEMPTS 3
 #define BASE_DELAY_SECONDS 30
 #define MAX_DELAYED_USERS 10
+#define DENTRY_CACHE_SIZE 4096 // Must be a power of two
+#define STRING_HEAP_BLOCK_SIZE 65536
+#define INODE_NONE UINT32_MAX
+#define SLAB_OBJECTS_PER_CHUNK 256
+#define TRIGRAM_EMPTY UINT32_MAX
+#define TRIGRAM_QUERY_MAX 64 // Distinct pattern trigrams a query intersects
+#define REGEX_MAX_PROGRAM 1024 // Instructions in a compiled name pattern
+#define WALK_MAX_WORKERS 64 // Worker threads plus the caller
+#define CHUNK_MIN_SIZE 2048 // Content-defined chunk bounds; cut points average 2^CHUNK_AVERAGE_BITS bytes apart
+#define CHUNK_MAX_SIZE 65536
+#define CHUNK_AVERAGE_BITS 13
+#define LZ_HASH_BITS 12 // Match finder table of the block compressor
+#define FILE_INLINE_SIZE 24 // Content bytes, terminator included, kept in the file node itself
+#define SMALL_CLASS_MIN 64  // Packed small-content slabs of 64, 128, 256 and 512 bytes
+#define SMALL_CLASS_COUNT 4
+#define EXPORT_BUFFER_SIZE (1 << 20) // Small content views are gathered into host writes of this size
+#define HOST_IO_DEFAULT_DEPTH 64 // Requests a batched load or out worker keeps in flight
+#define HOST_IO_DEFAULT_INFLIGHT_MB 64 // Read and write buffers all batched workers may hold at once
+#define DIRTY_PAGE_SIZE 4096 // Granularity of the written ranges kept for a writable mapping
 
 enum AuthorityLevel 
 {
@@ -58,24 +86,534 @@ struct User
     struct DelayParams delayParams;
 };
 
+enum InodeKind
+{
+    INODE_FREE,
+    INODE_FILE,
+    INODE_DIR
+};
+
+struct InternedName
+{
+    const char *name; // NULL marks an empty slot
+    uint32_t refs;    // Nodes carrying the name
+};
+
+// Interned node names: every distinct name is stored once, NUL-terminated,
+// packed back to back in blocks. A name no node carries any more is zeroed where
+// it lies; once those holes outweigh the live names, compactNames repacks them.
+struct StringHeap
+{
+    char **blocks;
+    int block_count;
+    size_t block_used;  // Bytes used in the last block
+    struct InternedName *slots; // Open-addressed intern table
+    size_t slot_count;
+    size_t name_count;
+    size_t bytes_used;
+    size_t bytes_released; // Bytes of released names still taking room in the blocks
+    unsigned long intern_hits; // Interned names that reused an existing copy
+};
+
+// Per-node metadata stored as parallel arrays indexed by a 32-bit inode id.
+// Kind-specific data lives in the struct File / struct Directory in nodes[].
+struct InodeTable
+{
+    unsigned char *kinds; // enum InodeKind
+    uint32_t *parents;    // Parent directory id; next free id while the slot is free
+    const char **names;   // Interned in the string heap
+    void **nodes;
+    uint32_t count;       // Ids handed out so far
+    uint32_t capacity;
+    uint32_t free_head;
+    uint32_t file_count;
+    uint32_t dir_count;
+};
+
+// Platform layer: locks, threads, atomic counters, the console, a timer and host file I/O,
+// on Win32 or POSIX
+#ifdef _WIN32
+#define HOST_PATH_SEPARATOR '\\'
+typedef CRITICAL_SECTION PlatformLock;
+typedef HANDLE PlatformThread;
+typedef HANDLE PlatformFile;
+#else
+#define HOST_PATH_SEPARATOR '/'
+typedef pthread_mutex_t PlatformLock;
+typedef pthread_t PlatformThread;
+typedef int PlatformFile;
+#endif
+
+// An open host directory, read one entry at a time
+struct HostDirectory
+{
+#ifdef _WIN32
+    HANDLE find;
+    WIN32_FIND_DATAA entry;
+    int started;
+#else
+    DIR *dir;
+#endif
+};
+
+// How a mapped host file will be read, passed on to madvise or the Win32 file flags
+enum AccessHint
+{
+    ACCESS_NORMAL,
+    ACCESS_SEQUENTIAL,
+    ACCESS_RANDOM,
+    ACCESS_WILLNEED // Start reading the whole file in now
+};
+
+struct MapOptions
+{
+    enum AccessHint hint;
+    int populate;   // Fault every page in while mapping
+    int huge_pages; // Ask for transparent huge pages where the system has them
+    int writable;   // Map shared and writable, so writes through the view reach the host file
+};
+
+// A view of a whole host file, read-only unless mapped writable; data is NULL for an empty file
+struct HostMapping
+{
+    const char *data;
+    uint64_t size;
+    int64_t modified; // Host modification time when mapped, to tell whether the file changed since
+    int writable;
+};
+
+// One host I/O request of a batch. Opens set 'file'; a size request sets 'length' from the
+// file at 'path'; reads and writes move 'length' bytes at 'offset', and 'done' says how many
+// actually moved (a read stops early at the end of the file).
+enum HostIoOp
+{
+    HOST_IO_OPEN_READ,
+    HOST_IO_OPEN_WRITE, // Creates or truncates
+    HOST_IO_SIZE,
+    HOST_IO_READ,
+    HOST_IO_WRITE,
+    HOST_IO_PREALLOCATE, // Best effort, like preallocateHostFile
+    HOST_IO_CLOSE
+};
+
+struct HostIoRequest
+{
+    enum HostIoOp op;
+    const char *path;
+    PlatformFile file;
+    void *buffer;
+    uint64_t length;
+    uint64_t offset;
+    uint64_t done;
+    int failed;
+    int lost; // Still held by a ring that died: the kernel may yet touch its buffer, so it is never freed
+};
+
+// Runs batches of host I/O requests. Backed by an io_uring instance where the host has one,
+// submitting a whole batch and reaping its completions in as few system calls as it can;
+// elsewhere the requests run one after another as plain blocking calls.
+struct HostIoQueue
+{
+    int uring;
+    int ring_fd;
+    unsigned entries;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    void *sqes;
+    size_t sqes_size;
+    unsigned *sq_head; // Ring fields inside the shared mappings
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    void *cqes;
+    unsigned long system_calls;
+    unsigned long operations;
+};
+
+// How recursive load and out reach the host
+enum HostIoBackend
+{
+    HOST_IO_THREADS, // Each worker maps or writes one file at a time with blocking calls
+    HOST_IO_URING    // Each worker batches its files through a HostIoQueue
+};
+
+struct HostIoSettings
+{
+    enum HostIoBackend backend;
+    unsigned queue_depth;
+    uint64_t inflight_bytes;
+    // Totals over batched loads and outs
+    unsigned long system_calls;
+    unsigned long operations;
+    int uring_missing; // Set once a batch found no usable io_uring and fell back to blocking calls
+};
+
+// A thread's share of a recursive load or out; batched workers keep their own queue
+struct HostIoWorker
+{
+    void *owner; // The HostImport or HostExport being worked on
+    struct HostIoQueue queue;
+    struct HostIoRequest *requests; // Three per claimed job
+    size_t *batch;                  // Job indices claimed for the current batch
+    size_t *slots;                  // Which claimed job each request of the current round serves
+    void **buffers;                 // Buffers owned by the current round, one per slot
+    unsigned depth;
+    uint64_t budget; // Buffer bytes this worker may hold at once
+};
+
+struct LoadOptions
+{
+    struct MapOptions map;
+    int keep_mapping; // Serve the file from the mapping instead of copying it into the block store
+    int lazy;         // Only record the host file now and map it when first read; implies keep_mapping
+};
+
+// A run of content bytes stored once and shared by every file whose chunking produced it
+struct Block
+{
+    uint64_t hash;
+    long refs;
+    uint32_t length;
+    uint32_t stored_length; // Bytes at data; less than length when they are LZ-compressed
+    char *data;
+    struct Block *next; // Next block in the same store slot
+};
+
+// A block of chunked content and the file offset it starts at
+struct BlockRef
+{
+    struct Block *block;
+    uint64_t offset;
+};
+
+// Content-addressed blocks for the whole file system, chained on a hash of their bytes.
+// Equal hashes are confirmed byte for byte before a block is shared.
+struct BlockStore
+{
+    struct Block **slots;
+    size_t slot_count;
+    size_t block_count;
+    uint64_t stored_bytes;     // Bytes held by blocks
+    uint64_t referenced_bytes; // Bytes of content pointing at blocks
+    unsigned long chunks;      // Chunks cut while storing content
+    unsigned long duplicates;  // Chunks that were already stored
+    double chunk_milliseconds;
+    size_t compressed_blocks;
+    uint64_t compressed_input_bytes; // Original length of the compressed blocks
+    uint64_t compressed_bytes;       // What they shrank to
+    double compress_milliseconds;
+    volatile int64_t decompressed_bytes; // Readers on any thread add to these
+    volatile int64_t decompress_nanoseconds;
+    PlatformLock lock;         // Guards the slots and counters so files can be chunked on several threads
+    uint64_t gear[256];        // Rolling hash table used to find cut points
+};
+
+// Whether the host file behind mapped content has been mapped yet. A lazy load only records
+// the file; the first reader maps it, and any reader arriving meanwhile waits for it.
+enum ContentState
+{
+    CONTENT_READY,
+    CONTENT_DEFERRED,   // 'mapping' holds the size and modification time recorded at load
+    CONTENT_MAPPING,    // A reader is mapping it now
+    CONTENT_UNAVAILABLE // The host file was gone or had changed when first read
+};
+
+// A run of pages of a writable mapping written since the last sync
+struct DirtyRange
+{
+    uint64_t start;
+    uint64_t end;
+};
+
+// File bytes, shared by reference count between copies. Written content is chunked into the
+// block store; appends and offset writes keep an owned buffer at data instead. Content with
+// more than one reference, in blocks, or in a read-only mapping is never written in place:
+// the writer takes a private copy first.
+struct Content
+{
+    long refs;
+    int mapped;        // data is a view of a host file, held by 'mapping'
+    int writable;      // The view is shared and writable: writes go to the host file, and the
+                       // pages they touch are kept in 'dirty', sorted and apart, until synced
+    struct DirtyRange *dirty;
+    uint32_t dirty_count;
+    uint32_t dirty_capacity;
+    volatile long state; // A ContentState
+    struct HostMapping mapping;
+    char *host_path;   // Where a mapping came from, so exports can copy from it in the kernel
+    char *data;
+    uint64_t capacity; // Bytes owned at data, always more than the size to keep a terminator
+    struct BlockStore *store; // Set when the bytes live in blocks rather than at data
+    struct BlockRef *blocks;
+    uint32_t block_count;
+};
+
+// Small content is owned by the file alone and kept next to it: in inline_data, or in a
+// packed slab object of the smallest size class that holds it and its terminator. 'small'
+// points at whichever is in use; larger content is a Content.
 struct File 
 {
-    char name[MAX_FILE_NAME_LENGTH];
-    char path[MAX_PATH_LENGTH];
-    HANDLE hMapFile;  // Handle to the shared memory map
-    LPVOID fileContent; // Pointer to the shared memory content
-    int size;
+    uint32_t id;
+    uint32_t name_pos; // Position in its name's posting list in the name index
+    uint32_t trigram_epoch; // Epoch of its postings in the trigram index, 0 when not indexed
+    uint32_t trigram_count; // Postings added under that epoch
+    uint64_t size;
+    struct Content *content; // NULL while empty or small
+    char *small;
+    char inline_data[FILE_INLINE_SIZE];
+};
+
+// Growable set of directory children: inode ids are reached through an
+// open-addressed hash on the name, and are put back in name order on
+// demand (childIndexSort) for listing.
+struct ChildIndex
+{
+    uint32_t *ids;
+    int count;
+    int capacity;
+    int *slots;     // Position in ids, or -1 for an empty slot
+    int slot_count; // Always a power of two
+    int sorted;     // Non-zero while ids are in name order
 };
 
 struct Directory 
 {
-    char name[MAX_FILE_NAME_LENGTH];
-    char path[MAX_PATH_LENGTH];
-    struct File *files[MAX_FILES];
-    int file_count;
-    struct Directory *subdirectories[MAX_SUB_DIRS];
-    int subdir_count;
+    uint32_t id;
     enum AuthorityLevel access; 
+    int content_indexed; // Files below are kept in the trigram index
+    int compressed;      // Content stored below is kept in compressed blocks
+    struct ChildIndex files;
+    struct ChildIndex subdirectories;
+};
+
+struct NamePosting
+{
+    const char *name; // Interned; NULL marks an empty slot
+    uint32_t *ids;    // Files currently carrying this name
+    uint32_t count;
+    uint32_t capacity;
+};
+
+// Global name -> file ids index kept current by file create/delete, used by find
+struct NameIndex
+{
+    struct NamePosting *slots; // Open-addressed on the name
+    size_t slot_count;
+    size_t name_count;
+};
+
+struct TrigramPosting
+{
+    uint32_t id;
+    uint32_t epoch; // Current while it equals the file's trigram_epoch
+};
+
+struct TrigramList
+{
+    uint32_t trigram; // Three content bytes; TRIGRAM_EMPTY marks an empty slot
+    uint32_t count;   // Postings are allocated to the power of two that holds them
+    struct TrigramPosting *postings;
+};
+
+// Optional trigram -> files index over the content of directories that opt in. Rewritten
+// or deleted files leave their old postings behind as stale; they are skipped by queries
+// and dropped by compaction once they outnumber the live ones.
+struct TrigramIndex
+{
+    struct TrigramList *slots; // Open-addressed on the trigram
+    size_t slot_count;
+    size_t trigram_count;
+    size_t live_postings;
+    size_t stale_postings;
+    uint32_t epoch;
+    size_t indexed_files;
+    uint64_t indexed_bytes;
+    double build_milliseconds;
+    unsigned long queries;
+    unsigned long compactions;
+};
+
+// Fixed-size object allocator for nodes. Objects are carved from chunks
+// of SLAB_OBJECTS_PER_CHUNK, so nodes created together (typically siblings)
+// sit next to each other, and freed objects are reused before new ones.
+struct Slab
+{
+    size_t object_size;
+    char **chunks;
+    int chunk_count;
+    int chunk_used;  // Objects carved from the last chunk
+    void *free_list; // Freed objects, linked through their first bytes
+    size_t live;
+    size_t free;     // Objects on the free list
+};
+
+// What a subtree teardown gave back
+struct TeardownStats
+{
+    size_t files;
+    size_t directories;
+    uint64_t content_bytes;
+    size_t node_bytes; // Node structs and child indexes
+    double milliseconds;
+};
+
+enum PatternKind
+{
+    PATTERN_GLOB, // *, ? and [...] against the whole name
+    PATTERN_REGEX // Unanchored unless ^ or $ are used
+};
+
+// One instruction of a compiled regex, run by a Pike VM
+struct RegexInstruction
+{
+    unsigned char op;
+    unsigned char c;
+    unsigned short x; // Jump target, or the class index for character classes
+    unsigned short y; // Second target of a split
+};
+
+struct NamePattern
+{
+    enum PatternKind kind;
+    char *source;
+    struct RegexInstruction *program;
+    int program_length;
+    unsigned char (*classes)[32]; // 256-bit character sets
+    int class_count;
+    char literal[MAX_FILE_NAME_LENGTH]; // Every match contains this; used to prefilter names
+    size_t literal_length;
+};
+
+// A borrowed, read-only range of a file's content. Compressed blocks are expanded into the
+// view's own scratch buffer, which is kept across calls with the same view and freed by
+// freeContentView.
+struct ContentView
+{
+    const char *data;
+    uint64_t length;
+    char *scratch;
+    const struct Block *scratch_block; // Block expanded in scratch
+};
+
+// Output a visitor produces during a walk; records are ordered by node path once the walk ends
+struct WalkRecord
+{
+    uint32_t id;
+    uint64_t value; // Breaks ties between records of the same node
+    char *text;     // Optional, owned by the record
+    char *path;     // Filled in when the records are merged
+};
+
+struct TreeWalk;
+
+struct WalkWorker
+{
+    struct TreeWalk *walk;
+    int index;
+    PlatformLock lock; // Guards the deque; the owner works the tail, thieves take the head
+    uint32_t *deque;
+    size_t head;
+    size_t tail;
+    size_t capacity;
+    struct WalkRecord *records;
+    size_t record_count;
+    size_t record_capacity;
+    uint64_t total; // Per-worker accumulator, summed after the walk
+    size_t directories;
+    size_t files;
+    size_t steals;
+};
+
+// A parallel walk over the subtree at 'root'. Visitors run concurrently on worker threads and
+// must only touch the node they are given, their own WalkWorker, and read-only shared state.
+struct TreeWalk
+{
+    struct FileSystem *fs;
+    uint32_t root;
+    int (*visitDirectory)(struct WalkWorker *worker, struct Directory *dir); // Nonzero skips the subtree
+    void (*visitFile)(struct WalkWorker *worker, struct File *file);
+    void *context;
+    int worker_count; // 0 picks one per processor; set to the number actually used
+    volatile long pending; // Directories queued or being visited
+    int failed;
+    // Results
+    uint64_t total;
+    size_t directories;
+    size_t files;
+    size_t steals;
+    struct WalkRecord *records;
+    size_t record_count;
+    double milliseconds;
+};
+
+// One host file of a recursive load. An I/O worker reads it into 'small' or 'content', then
+// the loading thread creates the file node from it.
+struct ImportJob
+{
+    char *host_path;
+    const char *name; // Points into host_path
+    uint32_t parent;  // Subsystem directory the file goes into
+    int compress;
+    volatile long done;
+    int failed;
+    uint64_t size;
+    char *small;      // Content too small for the block store, copied out of the mapping
+    struct Content *content;
+};
+
+struct HostImport
+{
+    struct FileSystem *fs;
+    struct LoadOptions options;
+    int batched;
+    struct ImportJob *jobs;
+    size_t job_count;
+    size_t job_capacity;
+    volatile long next; // Next job to claim
+    size_t directories;
+    size_t skipped;
+};
+
+// One file of a recursive out and where it goes on the host
+struct ExportJob
+{
+    const struct File *file;
+    char *host_path;
+    int result; // 1 written, 0 already up to date, -1 failed
+};
+
+struct HostExport
+{
+    int batched;
+    struct ExportJob *jobs;
+    size_t job_count;
+    size_t job_capacity;
+    volatile long next; // Next job to claim
+    size_t directories;
+    size_t failed_directories;
+};
+
+struct DentryCacheEntry
+{
+    char *path;
+    unsigned int hash;
+    unsigned int generation; // Entry is live only while it matches the cache generation
+    struct Directory *dir;
+};
+
+// Direct-mapped cache of resolved path -> directory lookups for goTo
+struct DentryCache
+{
+    struct DentryCacheEntry *entries;
+    unsigned int generation;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long invalidations;
 };
 
 struct FileSystem 
@@ -85,8 +623,84 @@ struct FileSystem
     struct User users[MAX_USERS];
     int user_count;
     struct User current_user;
+    struct InodeTable inodes;
+    struct StringHeap names;
+    struct NameIndex name_index;
+    struct TrigramIndex trigrams;
+    struct BlockStore blocks;
+    struct Slab file_slab;
+    struct Slab dir_slab;
+    struct Slab small_slabs[SMALL_CLASS_COUNT];
+    struct DentryCache dcache;
+    struct HostIoSettings host_io;
 };
 
+void initPlatformLock(PlatformLock *lock);
+
+void deletePlatformLock(PlatformLock *lock);
+
+void acquirePlatformLock(PlatformLock *lock);
+
+void releasePlatformLock(PlatformLock *lock);
+
+int startPlatformThread(PlatformThread *thread, void (*entry)(void *), void *argument);
+
+void joinPlatformThread(PlatformThread thread);
+
+void yieldPlatformThread(void);
+
+int processorCount(void);
+
+long atomicIncrement(volatile long *value);
+
+long atomicDecrement(volatile long *value);
+
+long atomicRead(volatile long *value);
+
+long atomicCompareExchange(volatile long *value, long expected, long desired);
+
+void atomicAdd64(volatile int64_t *value, int64_t amount);
+
+int readConsoleKey(void);
+
+double getMilliseconds(void);
+
+int mapHostFile(const char *path, const struct MapOptions *options, struct HostMapping *mapping);
+
+void unmapHostFile(struct HostMapping *mapping);
+
+int resizeHostMapping(const char *path, struct HostMapping *mapping, uint64_t size);
+
+int flushHostMapping(const struct HostMapping *mapping, uint64_t offset, uint64_t length);
+
+int openHostDirectory(const char *path, struct HostDirectory *dir);
+
+const char *nextHostEntry(struct HostDirectory *dir, int *isDirectory);
+
+void closeHostDirectory(struct HostDirectory *dir);
+
+int statHostFile(const char *path, uint64_t *size, int64_t *modified);
+
+int sameHostFile(const char *path, const char *otherPath);
+
+int createHostDirectory(const char *path);
+
+int createHostFile(const char *path, PlatformFile *file);
+
+void preallocateHostFile(PlatformFile file, uint64_t size);
+
+int initHostIoQueue(struct HostIoQueue *queue, unsigned depth, int useUring);
+
+void runHostIo(struct HostIoQueue *queue, struct HostIoRequest *requests, size_t count);
+
+void freeHostIoQueue(struct HostIoQueue *queue);
+
+int writeHostFile(PlatformFile file, const void *data, uint64_t length);
+
+void closeHostFile(PlatformFile file);
+
+uint64_t copyHostFile(PlatformFile target, const char *sourcePath, const struct HostMapping *expected, const char **method);
+
 void addUserToSystem(struct FileSystem *fs, const char *username, const char *password, enum AuthorityLevel accessLevel);
 
 void deleteUserFromSystem(struct FileSystem *fs, const char *username);
@@ -101,6 +715,56 @@ void initFile(struct File *file);
 
 void initDirectory(struct Directory *dir);
 
+void initChildIndex(struct ChildIndex *index);
+
+void freeChildIndex(struct ChildIndex *index);
+
+uint32_t childIndexFind(const struct InodeTable *table, const struct ChildIndex *index, const char *name);
+
+int childIndexInsert(const struct InodeTable *table, struct ChildIndex *index, uint32_t id);
+
+uint32_t childIndexRemove(const struct InodeTable *table, struct ChildIndex *index, const char *name);
+
+void childIndexSort(const struct InodeTable *table, struct ChildIndex *index);
+
+const char *internName(struct StringHeap *heap, const char *name);
+
+void releaseName(struct StringHeap *heap, const char *name);
+
+void compactNames(struct FileSystem *fs);
+
+void initSlab(struct Slab *slab, size_t objectSize);
+
+void *slabAlloc(struct Slab *slab);
+
+void slabFree(struct Slab *slab, void *object);
+
+void slabFreeBatch(struct Slab *slab, void **objects, size_t count);
+
+uint32_t allocInode(struct FileSystem *fs, enum InodeKind kind, const char *name, uint32_t parent, void *node);
+
+void freeInode(struct FileSystem *fs, uint32_t id);
+
+const char *nodeName(const struct FileSystem *fs, uint32_t id);
+
+int nameIndexAdd(struct FileSystem *fs, uint32_t fileId);
+
+void nameIndexRemove(struct FileSystem *fs, uint32_t fileId);
+
+const struct NamePosting *nameIndexLookup(const struct NameIndex *index, const char *name);
+
+int isInSubtree(const struct FileSystem *fs, uint32_t id, uint32_t ancestorId);
+
+size_t buildDirectoryPath(const struct FileSystem *fs, uint32_t id, char *buffer, size_t size);
+
+struct File *findFile(struct FileSystem *fs, struct Directory *dir, const char *name);
+
+struct File *newFileNode(struct FileSystem *fs, struct Directory *parentDir, const char *name);
+
+struct Directory *newDirectoryNode(struct FileSystem *fs, struct Directory *parentDir, const char *name);
+
+struct Directory *findSubdirectory(struct FileSystem *fs, struct Directory *dir, const char *name);
+
 void initFileSystem(struct FileSystem *fs);
 
 void createDirectory(struct FileSystem *fs, const char *path, const char *name);
@@ -109,29 +773,119 @@ int createFileInDir(struct FileSystem *fs, const char *path, const char *name);
 
 void writeFile(struct FileSystem *fs, const char *filePath, const char *fileName, const char *content);
 
+int appendFile(struct FileSystem *fs, struct File *file, const void *data, uint64_t length);
+
+int writeFileAt(struct FileSystem *fs, struct File *file, uint64_t offset, const void *data, uint64_t length);
+
+void appendToFileAtPath(struct FileSystem *fs, const char *filePath, const char *fileName, const char *content);
+
+void writeToFileAtPath(struct FileSystem *fs, const char *filePath, const char *fileName, uint64_t offset, const char *content);
+
 void readFile(struct FileSystem *fs, const char *filePath, const char *fileName);
 
+void initContentView(struct ContentView *view);
+
+int viewFileContent(const struct File *file, uint64_t offset, uint64_t length, struct ContentView *view);
+
+void freeContentView(struct ContentView *view);
+
+uint64_t readFileAt(const struct File *file, uint64_t offset, void *buffer, uint64_t length);
+
+void readFileRange(struct FileSystem *fs, const char *filePath, const char *fileName, uint64_t offset, uint64_t length);
+
 void deleteFileAtPath(struct FileSystem *fs, const char *path, const char *fileName);
 
 void deleteDirectoryAtPath(struct FileSystem *fs, const char *path);
 
+void teardownDirectory(struct FileSystem *fs, struct Directory *dir, struct TeardownStats *stats);
+
+uint64_t releaseFileContent(struct FileSystem *fs, struct File *file);
+
+int reserveFileContent(struct FileSystem *fs, struct File *file, uint64_t needed);
+
+int setFileContent(struct FileSystem *fs, struct File *file, const void *data, uint64_t length);
+
+int replaceFileContent(struct FileSystem *fs, struct File *file, const void *data, uint64_t length);
+
+int shareFileContent(struct FileSystem *fs, struct File *target, const struct File *source);
+
+int runTreeWalk(struct TreeWalk *walk);
+
+int walkEmit(struct WalkWorker *worker, uint32_t id, uint64_t value, const char *text);
+
+void freeTreeWalk(struct TreeWalk *walk);
+
+void diskUsageAtPath(struct FileSystem *fs, const char *path);
+
+void changeAccessLevelRecursive(struct FileSystem *fs, const char *dirPath, enum AuthorityLevel newAccessLevel);
+
+void grepInPath(struct FileSystem *fs, const char *path, const char *pattern);
+
+int isContentIndexed(const struct FileSystem *fs, uint32_t dirId);
+
+int trigramIndexFile(struct FileSystem *fs, struct File *file);
+
+int trigramIndexAppend(struct FileSystem *fs, struct File *file, size_t from);
+
+void trigramForgetFile(struct FileSystem *fs, struct File *file);
+
+void updateTrigramIndex(struct FileSystem *fs, struct File *file);
+
+unsigned char *trigramCandidates(struct FileSystem *fs, const char *pattern, size_t length);
+
+void setContentIndexing(struct FileSystem *fs, const char *path, int enable);
+
+int isContentCompressed(const struct FileSystem *fs, uint32_t dirId);
+
+void setContentCompression(struct FileSystem *fs, const char *path, int enable);
+
 void moveDirectoryAtPath(struct FileSystem *fs, const char *sourcePath, const char *destinationPath);
 
+void renameDirectoryAtPath(struct FileSystem *fs, const char *path, const char *newName);
+
 void moveFileAtPath(struct FileSystem *fs, const char *sourcePath, const char *destinationPath, const char *fileName);
 
+void copyFileToPath(struct FileSystem *fs, const char *sourcePath, const char *fileName, const char *destinationPath);
+
+void copyDirectoryToPath(struct FileSystem *fs, const char *sourcePath, const char *destinationPath);
+
 void searchFileInPath(struct FileSystem *fs, const char *path, const char *fileName);
 
+const char *findLiteral(const char *data, size_t length, const char *literal, size_t literalLength);
+
+int compileNamePattern(struct NamePattern *pattern, const char *source, enum PatternKind kind);
+
+int matchNamePattern(const struct NamePattern *pattern, const char *name);
+
+void freeNamePattern(struct NamePattern *pattern);
+
+void searchFilesByPattern(struct FileSystem *fs, const char *path, const char *source, enum PatternKind kind);
+
 struct Directory *goTo(struct FileSystem *fs, const char *path);
 
+void invalidateDentryCache(struct FileSystem *fs);
+
+void displayFileSystemStats(struct FileSystem *fs);
+
 void displayCurrentDirectory(struct FileSystem *fs, const char *path);
 
 void displayFileInDirectory(struct FileSystem *fs, const char *path, const char *fileName);
 
 char *getCurrentDirectoryPath(struct FileSystem *fs);
 
-int loadFileContent(const char *fileName, const char *windowsPath, const char *subsystemPath, struct FileSystem *fs);
+int loadFileContent(const char *fileName, const char *hostPath, const char *subsystemPath, struct FileSystem *fs, const struct LoadOptions *options);
+
+void setHostIo(struct FileSystem *fs, const char *backend, unsigned queueDepth, unsigned inflightMegabytes);
+
+void outHostTree(struct FileSystem *fs, const char *subsystemPath, const char *hostPath);
+
+void loadHostTree(struct FileSystem *fs, const char *hostPath, const char *subsystemPath, const struct LoadOptions *options);
+
+int outFileContent(const char *fileName, const char *subsystemPath, const char *hostPath, struct FileSystem *fs);
+
+int syncFileContent(struct File *file, uint64_t *flushed);
 
-int outFileContent(const char *fileName, const char *subsystemPath, const char *windowsPath, struct FileSystem *fs);
+void syncFiles(struct FileSystem *fs, const char *path, const char *fileName);
 
 void changeDirectoryAccessLevel(struct FileSystem *fs, const char *dirPath, enum AuthorityLevel newAccessLevel);
 